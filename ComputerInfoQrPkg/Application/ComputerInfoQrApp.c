@@ -2,6 +2,7 @@
 
 #include <IndustryStandard/Pci.h>
 #include <IndustryStandard/SmBios.h>
+#include <Guid/ConsoleOutDevice.h>
 #include <Guid/SmBios.h>
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
@@ -11,15 +12,18 @@
 #include <Library/UefiLib.h>
 
 #include <Protocol/GraphicsOutput.h>
+#include <Protocol/DevicePath.h>
 #include <Protocol/Dhcp4.h>
 #include <Protocol/Http.h>
 #include <Protocol/SimpleNetwork.h>
 #include <Protocol/SimpleTextIn.h>
 #include <Protocol/PciIo.h>
+#include <Protocol/SerialIo.h>
 #include <Protocol/ServiceBinding.h>
 #include <Protocol/Smbios.h>
 
 #include "QrCode.h"
+#include "QrMaskSearchMp.h"
 
 #ifndef PCI_HEADER_TYPE_DEVICE
 #define PCI_HEADER_TYPE_DEVICE 0x00
@@ -55,6 +59,9 @@
 #define SERVER_URL_MAX_LENGTH               512
 #define HARDWARE_INVENTORY_INITIAL_CAPACITY 512
 #define MAX_HARDWARE_ID_VARIANTS            9
+#define STRUCTURED_APPEND_FRAME_INTERVAL    EFI_TIMER_PERIOD_SECONDS(2)
+#define FRAMEBUFFER_BLT_BUFFER_LIMIT        SIZE_8MB
+#define STRUCTURED_APPEND_PROGRESS_HEIGHT   19
 
 STATIC BOOLEAN mWaitForKeyPressSupported = TRUE;
 
@@ -3319,181 +3326,656 @@ NextHandle:
   return Result;
 }
 
+STATIC
+BOOLEAN
+IsQrRowModuleDark(
+  IN CONST UINT64 *Row,
+  IN UINTN         Column
+  )
+{
+  return (BOOLEAN)((Row[Column / 64] >> (Column % 64)) & 0x1);
+}
+
+//
+// Prints the code as text, two characters per module so modules come out
+// roughly square, one row at a time from the iterator.
+//
 STATIC
 VOID
-RenderQuietRow(
-  IN UINTN TotalModules
+RenderQrCode(
+  IN OUT COMPUTER_INFO_QR_ROW_ITERATOR *Rows
   )
 {
-  UINTN Characters = TotalModules * 2;
-  CHAR16 RowBuffer[(COMPUTER_INFO_QR_MAX_SIZE + (QUIET_ZONE_SIZE * 2)) * 2 + 1];
+  UINT64 Row[COMPUTER_INFO_QR_PADDED_ROW_WORDS];
+  CHAR16 RowBuffer[(COMPUTER_INFO_QR_MAX_PADDED_SIZE * 2) + 1];
+
+  while (GetNextComputerInfoQrRow(Rows, Row)) {
+    UINTN Position = 0;
+
+    for (UINTN Column = 0; Column < Rows->PaddedWidth; Column++) {
+      CHAR16 Cell = IsQrRowModuleDark(Row, Column) ? L'\u2588' : L' ';
+      RowBuffer[Position++] = Cell;
+      RowBuffer[Position++] = Cell;
+    }
 
-  for (UINTN Index = 0; Index < Characters; Index++) {
-    RowBuffer[Index] = L' ';
+    RowBuffer[Position] = L'\0';
+    Print(L"%s\n", RowBuffer);
   }
-  RowBuffer[Characters] = L'\0';
-  Print(L"%s\n", RowBuffer);
 }
 
+//
+// Prints the code as text with two module rows per character row, using the
+// upper half, lower half and full block glyphs, so a symbol takes half the
+// rows and half the columns of RenderQrCode. The whole frame is assembled in
+// one buffer and sent with a single OutputString. Returns FALSE without
+// reading Rows when the console cannot draw the half blocks or the buffer
+// cannot be allocated.
+//
 STATIC
-VOID
-RenderQrRow(
-  IN CONST COMPUTER_INFO_QR_CODE *QrCode,
-  IN UINTN                        RowIndex
+BOOLEAN
+RenderQrHalfBlocks(
+  IN OUT COMPUTER_INFO_QR_ROW_ITERATOR *Rows
   )
 {
-  CHAR16 RowBuffer[(COMPUTER_INFO_QR_MAX_SIZE + (QUIET_ZONE_SIZE * 2)) * 2 + 1];
+  STATIC CONST CHAR16 Cells[] = { L' ', L'\u2580', L'\u2584', L'\u2588' };
+
+  if ((gST == NULL) || (gST->ConOut == NULL) ||
+      EFI_ERROR(gST->ConOut->TestString(gST->ConOut, (CHAR16 *)L"\u2580\u2584\u2588"))) {
+    return FALSE;
+  }
+
+  UINTN   LineLength = Rows->PaddedWidth + 2;
+  CHAR16 *Frame      = AllocatePool(((((Rows->PaddedHeight + 1) / 2) * LineLength) + 1) * sizeof(CHAR16));
+  if (Frame == NULL) {
+    return FALSE;
+  }
+
+  UINT64 Upper[COMPUTER_INFO_QR_PADDED_ROW_WORDS];
+  UINT64 Lower[COMPUTER_INFO_QR_PADDED_ROW_WORDS];
   UINTN  Position = 0;
 
-  for (UINTN Index = 0; Index < QUIET_ZONE_SIZE; Index++) {
-    RowBuffer[Position++] = L' ';
-    RowBuffer[Position++] = L' ';
+  while (GetNextComputerInfoQrRow(Rows, Upper)) {
+    if (!GetNextComputerInfoQrRow(Rows, Lower)) {
+      ZeroMem(Lower, sizeof(Lower));
+    }
+
+    for (UINTN Column = 0; Column < Rows->PaddedWidth; Column++) {
+      Frame[Position++] = Cells[IsQrRowModuleDark(Upper, Column) | (IsQrRowModuleDark(Lower, Column) << 1)];
+    }
+
+    Frame[Position++] = L'\r';
+    Frame[Position++] = L'\n';
   }
 
-  for (UINTN Column = 0; Column < QrCode->Size; Column++) {
-    if (QrCode->Modules[RowIndex][Column] != 0) {
-      RowBuffer[Position++] = L'\u2588';
-      RowBuffer[Position++] = L'\u2588';
-    } else {
-      RowBuffer[Position++] = L' ';
-      RowBuffer[Position++] = L' ';
+  Frame[Position] = L'\0';
+  gST->ConOut->OutputString(gST->ConOut, Frame);
+  FreePool(Frame);
+  return TRUE;
+}
+
+//
+// Terminal state for the serial renderer: bit 1 set for a dark foreground,
+// bit 0 set for a dark background.
+//
+#define SERIAL_CELL_FOREGROUND_DARK  0x2
+#define SERIAL_CELL_BACKGROUND_DARK  0x1
+#define SERIAL_CELL_STATE_COUNT      4
+#define SERIAL_CELL_UNREACHABLE      MAX_UINTN
+
+//
+// Bytes to switch the terminal from state From to state To with SGR 30/37
+// (foreground) and 40/47 (background).
+//
+STATIC
+UINTN
+GetSerialSgrLength(
+  IN UINTN From,
+  IN UINTN To
+  )
+{
+  UINTN Changed = From ^ To;
+
+  if (Changed == 0) {
+    return 0;
+  }
+
+  return (Changed == (SERIAL_CELL_FOREGROUND_DARK | SERIAL_CELL_BACKGROUND_DARK)) ? 8 : 5;
+}
+
+//
+// Bytes to draw a cell with the given upper and lower modules while the
+// terminal is in State, or SERIAL_CELL_UNREACHABLE when State cannot draw
+// it. Equal modules are a space on a matching background or a full block in
+// a matching foreground; mixed ones are an upper or lower half block, three
+// bytes of UTF-8 each.
+//
+STATIC
+UINTN
+GetSerialCellLength(
+  IN BOOLEAN UpperDark,
+  IN BOOLEAN LowerDark,
+  IN UINTN   State
+  )
+{
+  BOOLEAN ForegroundDark = (BOOLEAN)((State & SERIAL_CELL_FOREGROUND_DARK) != 0);
+  BOOLEAN BackgroundDark = (BOOLEAN)((State & SERIAL_CELL_BACKGROUND_DARK) != 0);
+
+  if (UpperDark == LowerDark) {
+    if (BackgroundDark == UpperDark) {
+      return 1;
+    }
+
+    return (ForegroundDark == UpperDark) ? 3 : SERIAL_CELL_UNREACHABLE;
+  }
+
+  return (ForegroundDark != BackgroundDark) ? 3 : SERIAL_CELL_UNREACHABLE;
+}
+
+STATIC
+UINTN
+AppendSerialSgr(
+  OUT CHAR8 *Buffer,
+  IN  UINTN  From,
+  IN  UINTN  To
+  )
+{
+  CHAR8 Foreground = ((To & SERIAL_CELL_FOREGROUND_DARK) != 0) ? '0' : '7';
+  CHAR8 Background = ((To & SERIAL_CELL_BACKGROUND_DARK) != 0) ? '0' : '7';
+  UINTN Changed    = From ^ To;
+  UINTN Length     = 0;
+
+  if (Changed == 0) {
+    return 0;
+  }
+
+  Buffer[Length++] = '\x1b';
+  Buffer[Length++] = '[';
+  if ((Changed & SERIAL_CELL_FOREGROUND_DARK) != 0) {
+    Buffer[Length++] = '3';
+    Buffer[Length++] = Foreground;
+    if ((Changed & SERIAL_CELL_BACKGROUND_DARK) != 0) {
+      Buffer[Length++] = ';';
     }
   }
 
-  for (UINTN Index = 0; Index < QUIET_ZONE_SIZE; Index++) {
-    RowBuffer[Position++] = L' ';
-    RowBuffer[Position++] = L' ';
+  if ((Changed & SERIAL_CELL_BACKGROUND_DARK) != 0) {
+    Buffer[Length++] = '4';
+    Buffer[Length++] = Background;
   }
 
-  RowBuffer[Position] = L'\0';
-  Print(L"%s\n", RowBuffer);
+  Buffer[Length++] = 'm';
+  return Length;
 }
 
 STATIC
-VOID
-RenderQrCode(
-  IN CONST COMPUTER_INFO_QR_CODE *QrCode
+UINTN
+AppendSerialCell(
+  OUT CHAR8   *Buffer,
+  IN  BOOLEAN  UpperDark,
+  IN  BOOLEAN  LowerDark,
+  IN  UINTN    State
   )
 {
-  UINTN DisplayWidth = QrCode->Size + (QUIET_ZONE_SIZE * 2);
+  BOOLEAN ForegroundDark = (BOOLEAN)((State & SERIAL_CELL_FOREGROUND_DARK) != 0);
+  BOOLEAN BackgroundDark = (BOOLEAN)((State & SERIAL_CELL_BACKGROUND_DARK) != 0);
+  CHAR8   Last;
 
-  for (UINTN Index = 0; Index < QUIET_ZONE_SIZE; Index++) {
-    RenderQuietRow(DisplayWidth);
+  if ((UpperDark == LowerDark) && (BackgroundDark == UpperDark)) {
+    Buffer[0] = ' ';
+    return 1;
   }
 
-  for (UINTN Row = 0; Row < QrCode->Size; Row++) {
-    RenderQrRow(QrCode, Row);
+  if (UpperDark == LowerDark) {
+    Last = (CHAR8)0x88;
+  } else if (ForegroundDark == UpperDark) {
+    Last = (CHAR8)0x80;
+  } else {
+    Last = (CHAR8)0x84;
   }
 
-  for (UINTN Index = 0; Index < QUIET_ZONE_SIZE; Index++) {
-    RenderQuietRow(DisplayWidth);
+  Buffer[0] = (CHAR8)0xE2;
+  Buffer[1] = (CHAR8)0x96;
+  Buffer[2] = Last;
+  return 3;
+}
+
+//
+// Largest frame BuildSerialQrFrame writes for a symbol of PaddedWidth by
+// PaddedHeight modules: a colour change and a glyph per cell, a cursor
+// position per character row, and the opening and closing SGR.
+//
+#define SERIAL_QR_FRAME_SIZE(PaddedWidth, PaddedHeight) \
+  (((((PaddedHeight) + 1) / 2) * (((PaddedWidth) * 11) + 12)) + 16)
+
+//
+// Writes the symbol as ANSI text for a serial terminal, two module rows per
+// character row like RenderQrHalfBlocks. Light modules are drawn in colour
+// 7 and dark ones in colour 0, so the code reads the same on any terminal
+// background. Each character row starts with a cursor position rather than
+// relying on line wrapping. The glyph and colours for every cell of a row
+// are chosen by a shortest path over the four foreground and background
+// combinations, so SGR sequences are only sent where switching colour is
+// cheaper than drawing with the current ones. Returns the frame length.
+//
+STATIC
+UINTN
+BuildSerialQrFrame(
+  IN OUT COMPUTER_INFO_QR_ROW_ITERATOR *Rows,
+  OUT    CHAR8                         *Frame
+  )
+{
+  UINT64 Upper[COMPUTER_INFO_QR_PADDED_ROW_WORDS];
+  UINT64 Lower[COMPUTER_INFO_QR_PADDED_ROW_WORDS];
+  UINT8  Trace[COMPUTER_INFO_QR_MAX_PADDED_SIZE][SERIAL_CELL_STATE_COUNT];
+  UINT8  Path[COMPUTER_INFO_QR_MAX_PADDED_SIZE];
+  UINTN  Cost[SERIAL_CELL_STATE_COUNT];
+  UINTN  Next[SERIAL_CELL_STATE_COUNT];
+  UINTN  Length = 0;
+  UINTN  Current;
+
+  //
+  // The terminal's colours are unknown, so both are set. Dark on light
+  // draws every cell without a further colour change, as a space or a block
+  // or half block glyph.
+  //
+  Current = SERIAL_CELL_FOREGROUND_DARK;
+  Length += AppendSerialSgr(&Frame[Length], Current ^ (SERIAL_CELL_FOREGROUND_DARK | SERIAL_CELL_BACKGROUND_DARK), Current);
+
+  for (UINTN CharacterRow = 0; GetNextComputerInfoQrRow(Rows, Upper); CharacterRow++) {
+    if (!GetNextComputerInfoQrRow(Rows, Lower)) {
+      ZeroMem(Lower, sizeof(Lower));
+    }
+
+    for (UINTN State = 0; State < SERIAL_CELL_STATE_COUNT; State++) {
+      Cost[State] = GetSerialSgrLength(Current, State);
+    }
+
+    for (UINTN Column = 0; Column < Rows->PaddedWidth; Column++) {
+      BOOLEAN UpperDark = IsQrRowModuleDark(Upper, Column);
+      BOOLEAN LowerDark = IsQrRowModuleDark(Lower, Column);
+
+      for (UINTN State = 0; State < SERIAL_CELL_STATE_COUNT; State++) {
+        UINTN CellLength = GetSerialCellLength(UpperDark, LowerDark, State);
+
+        Next[State] = SERIAL_CELL_UNREACHABLE;
+        if (CellLength == SERIAL_CELL_UNREACHABLE) {
+          continue;
+        }
+
+        for (UINTN Previous = 0; Previous < SERIAL_CELL_STATE_COUNT; Previous++) {
+          if (Cost[Previous] == SERIAL_CELL_UNREACHABLE) {
+            continue;
+          }
+
+          UINTN Candidate = Cost[Previous] + GetSerialSgrLength(Previous, State) + CellLength;
+          if (Candidate < Next[State]) {
+            Next[State]           = Candidate;
+            Trace[Column][State] = (UINT8)Previous;
+          }
+        }
+      }
+
+      CopyMem(Cost, Next, sizeof(Cost));
+    }
+
+    UINTN State = 0;
+    for (UINTN Candidate = 1; Candidate < SERIAL_CELL_STATE_COUNT; Candidate++) {
+      if (Cost[Candidate] < Cost[State]) {
+        State = Candidate;
+      }
+    }
+
+    for (UINTN Column = Rows->PaddedWidth; Column > 0; Column--) {
+      Path[Column - 1] = (UINT8)State;
+      State            = Trace[Column - 1][State];
+    }
+
+    Length += AsciiSPrint(&Frame[Length], 16, "\x1b[%u;1H", (UINT32)(CharacterRow + 1));
+    for (UINTN Column = 0; Column < Rows->PaddedWidth; Column++) {
+      Length += AppendSerialSgr(&Frame[Length], Current, Path[Column]);
+      Current = Path[Column];
+      Length += AppendSerialCell(&Frame[Length], IsQrRowModuleDark(Upper, Column), IsQrRowModuleDark(Lower, Column), Current);
+    }
   }
+
+  Frame[Length++] = '\x1b';
+  Frame[Length++] = '[';
+  Frame[Length++] = '0';
+  Frame[Length++] = 'm';
+  return Length;
 }
 
+//
+// Finds the serial port behind the console when every console output device
+// is a terminal on a serial port. Drawing through ConOut there sends every
+// module through the terminal driver's own translation and padding.
+//
 STATIC
 BOOLEAN
-RenderQrToFramebuffer(
-  IN CONST COMPUTER_INFO_QR_CODE *QrCode
+LocateSerialConsole(
+  OUT EFI_SERIAL_IO_PROTOCOL **SerialIo
   )
 {
-  if ((QrCode == NULL) || (QrCode->Size == 0)) {
+  EFI_HANDLE *Handles;
+  UINTN       HandleCount;
+
+  *SerialIo = NULL;
+  if ((gBS == NULL) ||
+      EFI_ERROR(gBS->LocateHandleBuffer(ByProtocol, &gEfiConsoleOutDeviceGuid, NULL, &HandleCount, &Handles))) {
     return FALSE;
   }
 
-  if (gBS == NULL) {
-    return FALSE;
+  for (UINTN Index = 0; Index < HandleCount; Index++) {
+    EFI_DEVICE_PATH_PROTOCOL *DevicePath;
+    EFI_HANDLE                SerialHandle;
+    EFI_SERIAL_IO_PROTOCOL   *Candidate = NULL;
+
+    if (!EFI_ERROR(gBS->HandleProtocol(Handles[Index], &gEfiDevicePathProtocolGuid, (VOID **)&DevicePath)) &&
+        !EFI_ERROR(gBS->LocateDevicePath(&gEfiSerialIoProtocolGuid, &DevicePath, &SerialHandle))) {
+      gBS->HandleProtocol(SerialHandle, &gEfiSerialIoProtocolGuid, (VOID **)&Candidate);
+    }
+
+    if (Candidate == NULL) {
+      *SerialIo = NULL;
+      break;
+    }
+
+    if (*SerialIo == NULL) {
+      *SerialIo = Candidate;
+    }
   }
 
-  EFI_GRAPHICS_OUTPUT_PROTOCOL *GraphicsOutput = NULL;
-  EFI_STATUS                    Status;
+  FreePool(Handles);
+  return (BOOLEAN)(*SerialIo != NULL);
+}
 
-  Status = gBS->LocateProtocol(
-                  &gEfiGraphicsOutputProtocolGuid,
-                  NULL,
-                  (VOID **)&GraphicsOutput
-                  );
-  if (EFI_ERROR(Status) || (GraphicsOutput == NULL)) {
+//
+// Draws the code on a serial-only console with BuildSerialQrFrame and one
+// SerialIo write, leaving the cursor below it. BytesWritten receives the
+// number of bytes sent. Returns FALSE when the console is not serial-only,
+// the symbol and the line below it do not fit the console's text mode, or
+// the frame could not be sent; Rows may then have been read.
+//
+STATIC
+BOOLEAN
+RenderQrToSerialConsole(
+  IN OUT COMPUTER_INFO_QR_ROW_ITERATOR *Rows,
+  OUT    UINTN                         *BytesWritten
+  )
+{
+  EFI_SERIAL_IO_PROTOCOL *SerialIo;
+  UINTN                   Columns;
+  UINTN                   TextRows;
+
+  *BytesWritten = 0;
+  if ((gST->ConOut == NULL) || (gST->ConOut->Mode == NULL) || !LocateSerialConsole(&SerialIo)) {
     return FALSE;
   }
 
-  if ((GraphicsOutput->Mode == NULL) || (GraphicsOutput->Mode->Info == NULL)) {
+  //
+  // Every character row is placed with an absolute cursor position, which a
+  // terminal clamps to its last line instead of scrolling, so a frame that
+  // does not fit would overwrite itself. The cursor also has to fit below
+  // the symbol.
+  //
+  if (EFI_ERROR(gST->ConOut->QueryMode(gST->ConOut, (UINTN)gST->ConOut->Mode->Mode, &Columns, &TextRows)) ||
+      (Rows->PaddedWidth > Columns) ||
+      ((Rows->PaddedHeight + 1) / 2 >= TextRows)) {
     return FALSE;
   }
 
-  CONST EFI_GRAPHICS_OUTPUT_MODE_INFORMATION *ModeInfo = GraphicsOutput->Mode->Info;
-  UINTN                                      HorizontalResolution = ModeInfo->HorizontalResolution;
-  UINTN                                      VerticalResolution   = ModeInfo->VerticalResolution;
+  CHAR8 *Frame = AllocatePool(SERIAL_QR_FRAME_SIZE(Rows->PaddedWidth, Rows->PaddedHeight));
+  if (Frame == NULL) {
+    return FALSE;
+  }
+
+  UINTN      FrameLength = BuildSerialQrFrame(Rows, Frame);
+  EFI_STATUS Status      = EFI_SUCCESS;
+  UINTN      Attribute   = (UINTN)gST->ConOut->Mode->Attribute;
+
+  while (*BytesWritten < FrameLength) {
+    UINTN Size = FrameLength - *BytesWritten;
+
+    Status = SerialIo->Write(SerialIo, &Size, &Frame[*BytesWritten]);
+    *BytesWritten += Size;
+    if ((EFI_ERROR(Status) && (Status != EFI_TIMEOUT)) || (Size == 0)) {
+      break;
+    }
+  }
+
+  FreePool(Frame);
 
-  if ((HorizontalResolution == 0) || (VerticalResolution == 0)) {
+  //
+  // A frame cut short can stop inside a colour change, so reset the colours
+  // again before handing the terminal back. The terminal driver skips
+  // SetAttribute when the attribute is unchanged, so it is moved off and
+  // back to resend the console's own colours.
+  //
+  if (*BytesWritten < FrameLength) {
+    CHAR8 Reset[] = "\x1b[0m";
+    UINTN Size    = sizeof(Reset) - 1;
+
+    SerialIo->Write(SerialIo, &Size, Reset);
+  }
+
+  gST->ConOut->SetAttribute(gST->ConOut, Attribute ^ EFI_BRIGHT);
+  gST->ConOut->SetAttribute(gST->ConOut, Attribute);
+  if (*BytesWritten < FrameLength) {
     return FALSE;
   }
 
-  UINTN TotalModules = QrCode->Size + (QUIET_ZONE_SIZE * 2);
-  if (TotalModules == 0) {
+  //
+  // Tell the terminal driver where the cursor went.
+  //
+  gST->ConOut->SetCursorPosition(gST->ConOut, 0, (Rows->PaddedHeight + 1) / 2);
+  return TRUE;
+}
+
+//
+// Finds the graphics output and its current resolution. Returns FALSE when
+// there is no usable framebuffer.
+//
+STATIC
+BOOLEAN
+LocateGraphicsOutput(
+  OUT EFI_GRAPHICS_OUTPUT_PROTOCOL **GraphicsOutput,
+  OUT UINTN                         *HorizontalResolution,
+  OUT UINTN                         *VerticalResolution
+  )
+{
+  if (gBS == NULL) {
     return FALSE;
   }
 
-  UINTN ModulePixelSize = HorizontalResolution / TotalModules;
-  UINTN VerticalModuleSize = VerticalResolution / TotalModules;
-  if (VerticalModuleSize < ModulePixelSize) {
-    ModulePixelSize = VerticalModuleSize;
+  EFI_STATUS Status;
+
+  *GraphicsOutput = NULL;
+  Status = gBS->LocateProtocol(
+                  &gEfiGraphicsOutputProtocolGuid,
+                  NULL,
+                  (VOID **)GraphicsOutput
+                  );
+  if (EFI_ERROR(Status) || (*GraphicsOutput == NULL)) {
+    return FALSE;
   }
 
-  if (ModulePixelSize == 0) {
+  if (((*GraphicsOutput)->Mode == NULL) || ((*GraphicsOutput)->Mode->Info == NULL)) {
     return FALSE;
   }
 
-  UINTN QrPixelSize = ModulePixelSize * TotalModules;
-  UINTN OffsetX = 0;
-  UINTN OffsetY = 0;
+  *HorizontalResolution = (*GraphicsOutput)->Mode->Info->HorizontalResolution;
+  *VerticalResolution   = (*GraphicsOutput)->Mode->Info->VerticalResolution;
+  return (BOOLEAN)((*HorizontalResolution != 0) && (*VerticalResolution != 0));
+}
 
-  if (HorizontalResolution > QrPixelSize) {
-    OffsetX = (HorizontalResolution - QrPixelSize) / 2;
+//
+// Pixels per module for a symbol of PaddedWidth by PaddedHeight modules,
+// quiet zone included, drawn as large as the screen allows. Modules stay
+// square, so the tighter of the two directions decides.
+//
+STATIC
+UINTN
+GetModulePixelSize(
+  IN UINTN PaddedWidth,
+  IN UINTN PaddedHeight,
+  IN UINTN HorizontalResolution,
+  IN UINTN VerticalResolution
+  )
+{
+  if ((PaddedWidth == 0) || (PaddedHeight == 0)) {
+    return 0;
   }
-  if (VerticalResolution > QrPixelSize) {
-    OffsetY = (VerticalResolution - QrPixelSize) / 2;
+
+  return MIN(HorizontalResolution / PaddedWidth, VerticalResolution / PaddedHeight);
+}
+
+//
+// Fills one screen rectangle with Color, skipping empty rectangles.
+//
+STATIC
+EFI_STATUS
+FillFramebufferRectangle(
+  IN EFI_GRAPHICS_OUTPUT_PROTOCOL  *GraphicsOutput,
+  IN EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Color,
+  IN UINTN                          X,
+  IN UINTN                          Y,
+  IN UINTN                          Width,
+  IN UINTN                          Height
+  )
+{
+  if ((Width == 0) || (Height == 0)) {
+    return EFI_SUCCESS;
   }
 
-  EFI_GRAPHICS_OUTPUT_BLT_PIXEL White = { 0xFF, 0xFF, 0xFF, 0x00 };
-  EFI_GRAPHICS_OUTPUT_BLT_PIXEL Black = { 0x00, 0x00, 0x00, 0x00 };
+  return GraphicsOutput->Blt(
+                           GraphicsOutput,
+                           Color,
+                           EfiBltVideoFill,
+                           0,
+                           0,
+                           X,
+                           Y,
+                           Width,
+                           Height,
+                           0
+                           );
+}
 
-  Status = GraphicsOutput->Blt(
-                               GraphicsOutput,
-                               &White,
-                               EfiBltVideoFill,
-                               0,
-                               0,
-                               0,
-                               0,
-                               HorizontalResolution,
-                               VerticalResolution,
-                               0
-                               );
-  if (EFI_ERROR(Status)) {
+//
+// Draws the scaled symbol into Buffer, ModulePixelSize * PaddedWidth pixels
+// per line. Each module row is expanded into one pixel line, which is then
+// copied to the ModulePixelSize - 1 lines below it.
+//
+STATIC
+VOID
+ComposeQrBltBuffer(
+  IN OUT COMPUTER_INFO_QR_ROW_ITERATOR *Rows,
+  IN     UINTN                          ModulePixelSize,
+  OUT    EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Buffer
+  )
+{
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL White      = { 0xFF, 0xFF, 0xFF, 0x00 };
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL Black      = { 0x00, 0x00, 0x00, 0x00 };
+  UINTN                         PixelWidth = ModulePixelSize * Rows->PaddedWidth;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Line      = Buffer;
+  UINT64                        Row[COMPUTER_INFO_QR_PADDED_ROW_WORDS];
+
+  while (GetNextComputerInfoQrRow(Rows, Row)) {
+    EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Pixel = Line;
+
+    for (UINTN Column = 0; Column < Rows->PaddedWidth; Column++) {
+      EFI_GRAPHICS_OUTPUT_BLT_PIXEL Color = IsQrRowModuleDark(Row, Column) ? Black : White;
+
+      for (UINTN Repeat = 0; Repeat < ModulePixelSize; Repeat++) {
+        *Pixel++ = Color;
+      }
+    }
+
+    for (UINTN Copy = 1; Copy < ModulePixelSize; Copy++) {
+      CopyMem(&Line[Copy * PixelWidth], Line, PixelWidth * sizeof(*Line));
+    }
+
+    Line += PixelWidth * ModulePixelSize;
+  }
+}
+
+//
+// Draws the symbol without a back buffer. The screen is cleared once; then
+// for each module row that has dark modules, every run of adjacent dark
+// modules is filled as one line of pixels and that line is copied down over
+// the rest of the module row with EfiBltVideoToVideo, doubling the copied
+// height each time. Light rows need no calls at all.
+//
+STATIC
+BOOLEAN
+RenderQrRunsToFramebuffer(
+  IN     EFI_GRAPHICS_OUTPUT_PROTOCOL  *GraphicsOutput,
+  IN OUT COMPUTER_INFO_QR_ROW_ITERATOR *Rows,
+  IN     UINTN                          HorizontalResolution,
+  IN     UINTN                          VerticalResolution,
+  IN     UINTN                          ModulePixelSize,
+  IN     UINTN                          OffsetX,
+  IN     UINTN                          OffsetY
+  )
+{
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL White        = { 0xFF, 0xFF, 0xFF, 0x00 };
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL Black        = { 0x00, 0x00, 0x00, 0x00 };
+  UINTN                         QrPixelWidth = ModulePixelSize * Rows->PaddedWidth;
+  EFI_STATUS                    Status;
+  UINT64                        Row[COMPUTER_INFO_QR_PADDED_ROW_WORDS];
+
+  if (EFI_ERROR(FillFramebufferRectangle(GraphicsOutput, &White, 0, 0, HorizontalResolution, VerticalResolution))) {
     return FALSE;
   }
 
-  for (UINTN Row = 0; Row < QrCode->Size; Row++) {
-    for (UINTN Column = 0; Column < QrCode->Size; Column++) {
-      if (QrCode->Modules[Row][Column] == 0) {
+  for (UINTN RowIndex = 0; GetNextComputerInfoQrRow(Rows, Row); RowIndex++) {
+    UINTN   PixelY  = OffsetY + RowIndex * ModulePixelSize;
+    BOOLEAN AnyDark = FALSE;
+    UINTN   Column  = 0;
+
+    while (Column < Rows->PaddedWidth) {
+      if (!IsQrRowModuleDark(Row, Column)) {
+        Column++;
         continue;
       }
 
-      UINTN PixelX = OffsetX + (Column + QUIET_ZONE_SIZE) * ModulePixelSize;
-      UINTN PixelY = OffsetY + (Row + QUIET_ZONE_SIZE) * ModulePixelSize;
+      UINTN RunStart = Column;
+      while ((Column < Rows->PaddedWidth) && IsQrRowModuleDark(Row, Column)) {
+        Column++;
+      }
 
+      Status = FillFramebufferRectangle(
+                 GraphicsOutput,
+                 &Black,
+                 OffsetX + RunStart * ModulePixelSize,
+                 PixelY,
+                 (Column - RunStart) * ModulePixelSize,
+                 1
+                 );
+      if (EFI_ERROR(Status)) {
+        return FALSE;
+      }
+
+      AnyDark = TRUE;
+    }
+
+    if (!AnyDark) {
+      continue;
+    }
+
+    for (UINTN Done = 1; Done < ModulePixelSize; Done *= 2) {
       Status = GraphicsOutput->Blt(
-                                     GraphicsOutput,
-                                     &Black,
-                                     EfiBltVideoFill,
-                                     0,
-                                     0,
-                                     PixelX,
-                                     PixelY,
-                                     ModulePixelSize,
-                                     ModulePixelSize,
-                                     0
-                                     );
+                                 GraphicsOutput,
+                                 NULL,
+                                 EfiBltVideoToVideo,
+                                 OffsetX,
+                                 PixelY,
+                                 OffsetX,
+                                 PixelY + Done,
+                                 QrPixelWidth,
+                                 MIN(Done, ModulePixelSize - Done),
+                                 0
+                                 );
       if (EFI_ERROR(Status)) {
         return FALSE;
       }
@@ -3503,6 +3985,257 @@ RenderQrToFramebuffer(
   return TRUE;
 }
 
+//
+// Sets Count 32-bit pixels to Value, storing two pixels at a time over the
+// part of the span that is 8-byte aligned. The stores are done here rather
+// than through SetMem64, whose speed depends on the BaseMemoryLib instance
+// the platform picked.
+//
+STATIC
+VOID
+WriteFramebufferSpan(
+  OUT UINT32 *Pixels,
+  IN  UINTN   Count,
+  IN  UINT32  Value
+  )
+{
+  if ((Count != 0) && (((UINTN)Pixels & 0x7) != 0)) {
+    *Pixels++ = Value;
+    Count--;
+  }
+
+  UINT64 *Pairs    = (UINT64 *)Pixels;
+  UINT64 Pair      = LShiftU64(Value, 32) | Value;
+  UINTN  PairCount = Count / 2;
+
+  for (UINTN Index = 0; Index < PairCount; Index++) {
+    Pairs[Index] = Pair;
+  }
+
+  if ((Count & 1) != 0) {
+    Pixels[Count - 1] = Value;
+  }
+}
+
+//
+// Writes the symbol straight into the linear framebuffer, without going
+// through Blt. Only 32-bit pixel formats with a known light value qualify;
+// black is zero in all of them. Each module row is expanded once into a
+// scratch line, in runs of equally coloured modules, and copied into the
+// ModulePixelSize framebuffer lines it covers. Returns FALSE without
+// touching Rows or the screen when the mode has no usable framebuffer, so
+// the caller can fall back to blitting.
+//
+STATIC
+BOOLEAN
+RenderQrToLinearFramebuffer(
+  IN     EFI_GRAPHICS_OUTPUT_PROTOCOL  *GraphicsOutput,
+  IN OUT COMPUTER_INFO_QR_ROW_ITERATOR *Rows,
+  IN     UINTN                          HorizontalResolution,
+  IN     UINTN                          VerticalResolution,
+  IN     UINTN                          ModulePixelSize,
+  IN     UINTN                          OffsetX,
+  IN     UINTN                          OffsetY
+  )
+{
+  EFI_GRAPHICS_OUTPUT_MODE_INFORMATION *Info = GraphicsOutput->Mode->Info;
+  UINT32                               Light;
+
+  switch (Info->PixelFormat) {
+    case PixelRedGreenBlueReserved8BitPerColor:
+    case PixelBlueGreenRedReserved8BitPerColor:
+      Light = 0x00FFFFFF;
+      break;
+
+    //
+    // The highest bit of any mask sets the pixel size, so bitmask modes can
+    // also be 16 or 24 bits per pixel. Those are left to Blt.
+    //
+    case PixelBitMask:
+      Light = Info->PixelInformation.RedMask | Info->PixelInformation.GreenMask | Info->PixelInformation.BlueMask;
+      if (HighBitSet32(Light | Info->PixelInformation.ReservedMask) < 24) {
+        return FALSE;
+      }
+
+      break;
+
+    default:
+      return FALSE;
+  }
+
+  UINTN Stride = Info->PixelsPerScanLine;
+  if ((Light == 0) ||
+      (GraphicsOutput->Mode->FrameBufferBase == 0) ||
+      (Stride < HorizontalResolution) ||
+      ((((VerticalResolution - 1) * Stride) + HorizontalResolution) * sizeof(UINT32) > GraphicsOutput->Mode->FrameBufferSize)) {
+    return FALSE;
+  }
+
+  UINTN  QrPixelWidth  = ModulePixelSize * Rows->PaddedWidth;
+  UINTN  QrPixelHeight = ModulePixelSize * Rows->PaddedHeight;
+  UINTN  Right         = OffsetX + QrPixelWidth;
+  UINT32 *Line         = AllocatePool(QrPixelWidth * sizeof(*Line));
+  if (Line == NULL) {
+    return FALSE;
+  }
+
+  UINT32 *Framebuffer = (UINT32 *)(UINTN)GraphicsOutput->Mode->FrameBufferBase;
+
+  //
+  // The bands above and below the symbol are contiguous when there is no
+  // padding at the end of each scan line.
+  //
+  if (Stride == HorizontalResolution) {
+    WriteFramebufferSpan(Framebuffer, OffsetY * Stride, Light);
+    WriteFramebufferSpan(
+      &Framebuffer[(OffsetY + QrPixelHeight) * Stride],
+      (VerticalResolution - OffsetY - QrPixelHeight) * Stride,
+      Light
+      );
+  } else {
+    for (UINTN Y = 0; Y < OffsetY; Y++) {
+      WriteFramebufferSpan(&Framebuffer[Y * Stride], HorizontalResolution, Light);
+    }
+
+    for (UINTN Y = OffsetY + QrPixelHeight; Y < VerticalResolution; Y++) {
+      WriteFramebufferSpan(&Framebuffer[Y * Stride], HorizontalResolution, Light);
+    }
+  }
+
+  UINT64 Row[COMPUTER_INFO_QR_PADDED_ROW_WORDS];
+  UINTN  Y = OffsetY;
+
+  while (GetNextComputerInfoQrRow(Rows, Row)) {
+    UINTN Column = 0;
+
+    while (Column < Rows->PaddedWidth) {
+      UINTN   RunStart = Column;
+      BOOLEAN Dark     = IsQrRowModuleDark(Row, Column);
+
+      while ((Column < Rows->PaddedWidth) && (IsQrRowModuleDark(Row, Column) == Dark)) {
+        Column++;
+      }
+
+      WriteFramebufferSpan(&Line[RunStart * ModulePixelSize], (Column - RunStart) * ModulePixelSize, Dark ? 0 : Light);
+    }
+
+    for (UINTN Repeat = 0; Repeat < ModulePixelSize; Repeat++, Y++) {
+      UINT32 *ScanLine = &Framebuffer[Y * Stride];
+
+      WriteFramebufferSpan(ScanLine, OffsetX, Light);
+      CopyMem(&ScanLine[OffsetX], Line, QrPixelWidth * sizeof(*Line));
+      WriteFramebufferSpan(&ScanLine[Right], HorizontalResolution - Right, Light);
+    }
+  }
+
+  FreePool(Line);
+  return TRUE;
+}
+
+//
+// Draws the symbol, quiet zone included, as large as the screen allows. The
+// scaled symbol is composed in memory and sent with one blit, and only the
+// margins around it are cleared, so the screen takes at most five GOP calls
+// instead of one per dark module. When that buffer would exceed
+// FRAMEBUFFER_BLT_BUFFER_LIMIT, as on 4K panels, or cannot be allocated, the
+// symbol is drawn run by run straight on the screen instead. Modes with a
+// linear framebuffer in a known pixel format skip Blt and are written
+// directly. The bottom ReservedHeight lines are left out when sizing and
+// centering the symbol and are only cleared, so the caller can draw there.
+//
+STATIC
+BOOLEAN
+RenderQrToFramebuffer(
+  IN OUT COMPUTER_INFO_QR_ROW_ITERATOR *Rows,
+  IN     UINTN                          ReservedHeight
+  )
+{
+  if (Rows == NULL) {
+    return FALSE;
+  }
+
+  EFI_GRAPHICS_OUTPUT_PROTOCOL *GraphicsOutput;
+  EFI_STATUS                    Status;
+  UINTN                         HorizontalResolution;
+  UINTN                         VerticalResolution;
+
+  if (!LocateGraphicsOutput(&GraphicsOutput, &HorizontalResolution, &VerticalResolution) ||
+      (ReservedHeight >= VerticalResolution)) {
+    return FALSE;
+  }
+
+  UINTN SymbolArea      = VerticalResolution - ReservedHeight;
+  UINTN ModulePixelSize = GetModulePixelSize(Rows->PaddedWidth, Rows->PaddedHeight, HorizontalResolution, SymbolArea);
+  if (ModulePixelSize == 0) {
+    return FALSE;
+  }
+
+  UINTN QrPixelWidth  = ModulePixelSize * Rows->PaddedWidth;
+  UINTN QrPixelHeight = ModulePixelSize * Rows->PaddedHeight;
+  UINTN OffsetX       = (HorizontalResolution - QrPixelWidth) / 2;
+  UINTN OffsetY       = (SymbolArea - QrPixelHeight) / 2;
+
+  if (RenderQrToLinearFramebuffer(GraphicsOutput, Rows, HorizontalResolution, VerticalResolution, ModulePixelSize, OffsetX, OffsetY)) {
+    return TRUE;
+  }
+
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Buffer     = NULL;
+  UINTN                          BufferSize = QrPixelWidth * QrPixelHeight * sizeof(*Buffer);
+
+  if (BufferSize <= FRAMEBUFFER_BLT_BUFFER_LIMIT) {
+    Buffer = AllocatePool(BufferSize);
+  }
+
+  if (Buffer == NULL) {
+    return RenderQrRunsToFramebuffer(
+             GraphicsOutput,
+             Rows,
+             HorizontalResolution,
+             VerticalResolution,
+             ModulePixelSize,
+             OffsetX,
+             OffsetY
+             );
+  }
+
+  ComposeQrBltBuffer(Rows, ModulePixelSize, Buffer);
+
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL White = { 0xFF, 0xFF, 0xFF, 0x00 };
+  UINTN                         Right = OffsetX + QrPixelWidth;
+  UINTN                         Below = OffsetY + QrPixelHeight;
+
+  Status = FillFramebufferRectangle(GraphicsOutput, &White, 0, 0, HorizontalResolution, OffsetY);
+  if (!EFI_ERROR(Status)) {
+    Status = FillFramebufferRectangle(GraphicsOutput, &White, 0, Below, HorizontalResolution, VerticalResolution - Below);
+  }
+
+  if (!EFI_ERROR(Status)) {
+    Status = FillFramebufferRectangle(GraphicsOutput, &White, 0, OffsetY, OffsetX, QrPixelHeight);
+  }
+
+  if (!EFI_ERROR(Status)) {
+    Status = FillFramebufferRectangle(GraphicsOutput, &White, Right, OffsetY, HorizontalResolution - Right, QrPixelHeight);
+  }
+
+  if (!EFI_ERROR(Status)) {
+    Status = GraphicsOutput->Blt(
+                               GraphicsOutput,
+                               Buffer,
+                               EfiBltBufferToVideo,
+                               0,
+                               0,
+                               OffsetX,
+                               OffsetY,
+                               QrPixelWidth,
+                               QrPixelHeight,
+                               0
+                               );
+  }
+
+  FreePool(Buffer);
+  return (BOOLEAN)!EFI_ERROR(Status);
+}
+
 STATIC
 EFI_STATUS
 WaitForKeyPress(
@@ -3538,21 +4271,310 @@ WaitForKeyPress(
   }
 }
 
+//
+// Returns TRUE when the code was drawn to the framebuffer and FALSE when it
+// was printed to the text console instead. On the framebuffer the bottom
+// ReservedHeight lines are kept clear of the symbol and its quiet zone.
+//
 STATIC
-VOID
+BOOLEAN
 ShowQrScreen(
-  IN CONST COMPUTER_INFO_QR_CODE *QrCode
+  IN CONST COMPUTER_INFO_QR_CODE *QrCode,
+  IN UINTN                        ReservedHeight
   )
 {
-  if (RenderQrToFramebuffer(QrCode)) {
-    return;
+  COMPUTER_INFO_QR_ROW_ITERATOR Rows;
+
+  if (EFI_ERROR(InitializeComputerInfoQrCodeRowIterator(QrCode, QUIET_ZONE_SIZE, &Rows))) {
+    return FALSE;
+  }
+
+  if (RenderQrToFramebuffer(&Rows, ReservedHeight)) {
+    return TRUE;
   }
 
   if (gST->ConOut != NULL) {
     gST->ConOut->ClearScreen(gST->ConOut);
   }
 
-  RenderQrCode(QrCode);
+  UINTN BytesWritten;
+
+  InitializeComputerInfoQrCodeRowIterator(QrCode, QUIET_ZONE_SIZE, &Rows);
+  if (RenderQrToSerialConsole(&Rows, &BytesWritten)) {
+    Print(L"%u bytes sent to the serial console\n", (UINT32)BytesWritten);
+    return FALSE;
+  }
+
+  InitializeComputerInfoQrCodeRowIterator(QrCode, QUIET_ZONE_SIZE, &Rows);
+  if (!RenderQrHalfBlocks(&Rows)) {
+    RenderQrCode(&Rows);
+  }
+
+  return FALSE;
+}
+
+//
+// A square QR symbol leaves the sides of a wide screen empty. When the
+// payload is short enough for rMQR and the rectangular symbol gets larger
+// modules at the current mode, QrCode is replaced with it; on equal module
+// sizes QR is kept, since more readers decode it.
+//
+STATIC
+VOID
+PreferRmqrOnWideScreens(
+  IN OUT COMPUTER_INFO_QR_ENCODER_CONTEXT *Encoder,
+  IN     CONST UINT8                      *Payload,
+  IN     UINTN                             PayloadLength,
+  IN OUT COMPUTER_INFO_QR_CODE            *QrCode
+  )
+{
+  EFI_GRAPHICS_OUTPUT_PROTOCOL *GraphicsOutput;
+  UINTN                         HorizontalResolution;
+  UINTN                         VerticalResolution;
+
+  if ((PayloadLength > COMPUTER_INFO_QR_RMQR_MAX_PAYLOAD_LENGTH) ||
+      !LocateGraphicsOutput(&GraphicsOutput, &HorizontalResolution, &VerticalResolution)) {
+    return;
+  }
+
+  COMPUTER_INFO_QR_CODE *RmqrCode = AllocatePool(sizeof(COMPUTER_INFO_QR_CODE));
+  if (RmqrCode == NULL) {
+    return;
+  }
+
+  EFI_STATUS Status = EncodeComputerInfoQrRmqr(
+                        Encoder,
+                        Payload,
+                        PayloadLength,
+                        ComputerInfoQrEccAutoBoost,
+                        HorizontalResolution,
+                        VerticalResolution,
+                        QUIET_ZONE_SIZE,
+                        RmqrCode
+                        );
+  if (!EFI_ERROR(Status) &&
+      (GetModulePixelSize(
+         RmqrCode->Width + (2 * QUIET_ZONE_SIZE),
+         RmqrCode->Height + (2 * QUIET_ZONE_SIZE),
+         HorizontalResolution,
+         VerticalResolution
+         ) >
+       GetModulePixelSize(
+         QrCode->Width + (2 * QUIET_ZONE_SIZE),
+         QrCode->Height + (2 * QUIET_ZONE_SIZE),
+         HorizontalResolution,
+         VerticalResolution
+         ))) {
+    CopyMem(QrCode, RmqrCode, sizeof(COMPUTER_INFO_QR_CODE));
+  }
+
+  FreePool(RmqrCode);
+}
+
+//
+// Draws one box per part in the STRUCTURED_APPEND_PROGRESS_HEIGHT band at
+// the bottom of the screen, dark for the parts shown so far and grey for
+// the rest. The band lies below the symbol's quiet zone.
+//
+STATIC
+VOID
+DrawStructuredAppendProgress(
+  IN UINTN Index,
+  IN UINTN Count
+  )
+{
+  EFI_GRAPHICS_OUTPUT_PROTOCOL  *GraphicsOutput;
+  UINTN                          HorizontalResolution;
+  UINTN                          VerticalResolution;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  Dark = { 0x00, 0x00, 0x00, 0x00 };
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  Grey = { 0xC0, 0xC0, 0xC0, 0x00 };
+
+  if (!LocateGraphicsOutput(&GraphicsOutput, &HorizontalResolution, &VerticalResolution) ||
+      (VerticalResolution < STRUCTURED_APPEND_PROGRESS_HEIGHT)) {
+    return;
+  }
+
+  //
+  // Boxes are as tall as the band allows less a margin, and as wide as
+  // that or the screen width divided between them, whichever is smaller.
+  //
+  UINTN Margin  = STRUCTURED_APPEND_PROGRESS_HEIGHT / 4;
+  UINTN BoxSize = STRUCTURED_APPEND_PROGRESS_HEIGHT - (2 * Margin);
+  UINTN Pitch   = MIN(BoxSize + Margin, HorizontalResolution / Count);
+  if (Pitch <= 1) {
+    return;
+  }
+
+  UINTN BoxWidth = MIN(BoxSize, Pitch - 1);
+  UINTN Left     = (HorizontalResolution - (Pitch * Count)) / 2;
+  UINTN Top      = VerticalResolution - STRUCTURED_APPEND_PROGRESS_HEIGHT + Margin;
+
+  for (UINTN Part = 0; Part < Count; Part++) {
+    FillFramebufferRectangle(GraphicsOutput, (Part <= Index) ? &Dark : &Grey, Left + (Part * Pitch), Top, BoxWidth, BoxSize);
+  }
+}
+
+STATIC
+VOID
+ShowStructuredAppendFrame(
+  IN CONST COMPUTER_INFO_QR_CODE *QrCode,
+  IN UINTN                        Index,
+  IN UINTN                        Count
+  )
+{
+  CHAR16 Progress[COMPUTER_INFO_QR_MAX_STRUCTURED_APPEND_SYMBOLS + 1];
+
+  //
+  // Text drawn over a framebuffer lands wherever the console centres its
+  // grid, which can be inside the symbol, so there the progress is drawn as
+  // boxes in a band kept free below the symbol. On the text and serial
+  // consoles the indicator is printed below the code.
+  //
+  if (ShowQrScreen(QrCode, STRUCTURED_APPEND_PROGRESS_HEIGHT)) {
+    DrawStructuredAppendProgress(Index, Count);
+    return;
+  }
+
+  for (UINTN Part = 0; Part < Count; Part++) {
+    Progress[Part] = (Part <= Index) ? L'#' : L'.';
+  }
+
+  Progress[Count] = L'\0';
+  Print(L"Part %u of %u [%s]  Press any key to stop", (UINT32)(Index + 1), (UINT32)Count, Progress);
+}
+
+//
+// Cycles through a Structured Append sequence on a periodic timer until a
+// key is pressed.
+//
+STATIC
+EFI_STATUS
+ShowStructuredAppendScreens(
+  IN CONST COMPUTER_INFO_QR_CODE *QrCodes,
+  IN UINTN                        Count
+  )
+{
+  if ((QrCodes == NULL) || (Count == 0) || (gBS == NULL) || (gST == NULL) || (gST->ConIn == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  EFI_STATUS Status;
+  EFI_EVENT  Timer = NULL;
+
+  Status = gBS->CreateEvent(EVT_TIMER, TPL_CALLBACK, NULL, NULL, &Timer);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  Status = gBS->SetTimer(Timer, TimerPeriodic, STRUCTURED_APPEND_FRAME_INTERVAL);
+  if (EFI_ERROR(Status)) {
+    gBS->CloseEvent(Timer);
+    return Status;
+  }
+
+  UINTN Frame = 0;
+  while (TRUE) {
+    ShowStructuredAppendFrame(&QrCodes[Frame], Frame, Count);
+
+    EFI_EVENT Events[2];
+    UINTN     EventIndex;
+
+    Events[0] = Timer;
+    Events[1] = gST->ConIn->WaitForKey;
+    Status = gBS->WaitForEvent(ARRAY_SIZE(Events), Events, &EventIndex);
+    if (EFI_ERROR(Status)) {
+      break;
+    }
+
+    if (EventIndex == 1) {
+      EFI_INPUT_KEY Key;
+      gST->ConIn->ReadKeyStroke(gST->ConIn, &Key);
+      break;
+    }
+
+    Frame = (Frame + 1) % Count;
+  }
+
+  gBS->SetTimer(Timer, TimerCancel, 0);
+  gBS->CloseEvent(Timer);
+  return Status;
+}
+
+//
+// The PCI inventory is far larger than one symbol holds, so it is shown as a
+// Structured Append sequence that a reader joins back together.
+//
+STATIC
+VOID
+ShowHardwareInventoryQrCodes(
+  VOID
+  )
+{
+  EFI_STATUS                       Status;
+  CHAR8                            *Payload       = NULL;
+  UINTN                            PayloadLength  = 0;
+  COMPUTER_INFO_QR_CODE            *QrCodes       = NULL;
+  UINTN                            SymbolCount    = 0;
+  COMPUTER_INFO_QR_ENCODER_CONTEXT QrEncoder;
+
+  Status = BuildHardwareInventoryPayload(&Payload, &PayloadLength);
+  if (EFI_ERROR(Status)) {
+    Print(L"Unable to build hardware inventory payload: %r\n", Status);
+    goto Done;
+  }
+
+  Status = InitializeComputerInfoQrEncoder(&QrEncoder);
+  if (EFI_ERROR(Status)) {
+    Print(L"QR code generation failed: %r\n", Status);
+    goto Done;
+  }
+
+  Status = EncodeComputerInfoQrStructuredAppend(
+             &QrEncoder,
+             (CONST UINT8 *)Payload,
+             PayloadLength,
+             ComputerInfoQrEccAutoBoost,
+             NULL,
+             &SymbolCount
+             );
+  if (Status == EFI_BUFFER_TOO_SMALL) {
+    QrCodes = AllocatePool(SymbolCount * sizeof(COMPUTER_INFO_QR_CODE));
+    if (QrCodes == NULL) {
+      Status = EFI_OUT_OF_RESOURCES;
+    } else {
+      Status = EncodeComputerInfoQrStructuredAppend(
+                 &QrEncoder,
+                 (CONST UINT8 *)Payload,
+                 PayloadLength,
+                 ComputerInfoQrEccAutoBoost,
+                 QrCodes,
+                 &SymbolCount
+                 );
+    }
+  }
+
+  FreeComputerInfoQrEncoder(&QrEncoder);
+  FreeComputerInfoQrCaches();
+
+  if (EFI_ERROR(Status)) {
+    Print(L"QR code generation failed: %r\n", Status);
+  } else {
+    ShowStructuredAppendScreens(QrCodes, SymbolCount);
+  }
+
+Done:
+  if (QrCodes != NULL) {
+    FreePool(QrCodes);
+  }
+
+  if (Payload != NULL) {
+    FreePool(Payload);
+  }
+
+  if (EFI_ERROR(Status)) {
+    Print(L"\nPress any key to return to the menu...\n");
+    WaitForKeyPress(NULL);
+  }
 }
 
 STATIC
@@ -3573,6 +4595,7 @@ GetMenuSelection(
     Print(L"3. Display networking information\n");
     Print(L"4. Display JSON payload\n");
     Print(L"5. Renew DHCP lease(s)\n");
+    Print(L"6. Display hardware inventory QR codes\n");
     Print(L"Q. Quit\n\n");
     Print(L"Select an option: ");
 
@@ -3585,7 +4608,7 @@ GetMenuSelection(
 
     CHAR16 Value = Key.UnicodeChar;
     if ((Value == L'1') || (Value == L'2') || (Value == L'3') || (Value == L'4') ||
-        (Value == L'5') || (Value == L'Q') || (Value == L'q')) {
+        (Value == L'5') || (Value == L'6') || (Value == L'Q') || (Value == L'q')) {
       *Selection = Value;
       return EFI_SUCCESS;
     }
@@ -3668,8 +4691,32 @@ UefiMain(
     return EFI_BAD_BUFFER_SIZE;
   }
 
-  COMPUTER_INFO_QR_CODE QrCode;
-  Status = GenerateComputerInfoQrCode((CONST UINT8 *)JsonPayload, JsonLength, &QrCode);
+  InstallComputerInfoQrMpMaskSearch();
+
+  //
+  // The symbol is read off a screen, often at an angle or through glare, so
+  // spend whatever room the smallest fitting version leaves on error
+  // correction.
+  //
+  COMPUTER_INFO_QR_ENCODER_CONTEXT QrEncoder;
+  COMPUTER_INFO_QR_CODE            QrCode;
+  Status = InitializeComputerInfoQrEncoder(&QrEncoder);
+  if (!EFI_ERROR(Status)) {
+    Status = EncodeComputerInfoQrCode(
+               &QrEncoder,
+               (CONST UINT8 *)JsonPayload,
+               JsonLength,
+               ComputerInfoQrEccAutoBoost,
+               &QrCode
+               );
+    if (!EFI_ERROR(Status)) {
+      PreferRmqrOnWideScreens(&QrEncoder, (CONST UINT8 *)JsonPayload, JsonLength, &QrCode);
+    }
+
+    FreeComputerInfoQrEncoder(&QrEncoder);
+  }
+
+  FreeComputerInfoQrCaches();
   if (EFI_ERROR(Status)) {
     Print(L"QR code generation failed: %r\n", Status);
     return Status;
@@ -3698,7 +4745,7 @@ UefiMain(
 
     switch (Selection) {
       case L'1':
-        ShowQrScreen(&QrCode);
+        ShowQrScreen(&QrCode, 0);
         WaitForKeyPress(NULL);
         break;
 
@@ -3726,6 +4773,10 @@ UefiMain(
         RenewDhcpLeasesFromMenu();
         break;
 
+      case L'6':
+        ShowHardwareInventoryQrCodes();
+        break;
+
       case L'Q':
       case L'q':
         ExitRequested = TRUE;
@@ -1,84 +1,148 @@
 #include "QrCode.h"
+#include "QrCodeTables.h"
 
 #include <Library/BaseMemoryLib.h>
 #include <Library/BaseLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/SynchronizationLib.h>
 
-#define GF_SIZE                       256
-#define GF_GENERATOR_POLYNOMIAL       0x11D
+#if (QR_TABLES_MIN_VERSION != COMPUTER_INFO_QR_MIN_VERSION) || (QR_TABLES_MAX_VERSION != COMPUTER_INFO_QR_MAX_VERSION)
+#error "QrCodeTables.h is out of date; rerun ComputerInfoQrPkg/Scripts/GenerateQrTables.py"
+#endif
+
+#if RMQR_TABLES_VERSION_COUNT != COMPUTER_INFO_QR_RMQR_VERSION_COUNT
+#error "QrCodeTables.h is out of date; rerun ComputerInfoQrPkg/Scripts/GenerateQrTables.py"
+#endif
 
 #define QR_MAX_ALIGNMENT_PATTERN_COUNT  ((COMPUTER_INFO_QR_MAX_VERSION / 7) + 2)
 
+//
+// Stage timing for the host benchmark. A build that defines
+// COMPUTER_INFO_QR_STAGE_TIMING accumulates time stamp counter ticks per
+// encoder stage in mQrStageTicks; every other build compiles the hooks to
+// nothing. The totals assume the serial mask search backend, since
+// concurrent workers would race on them.
+//
+#if defined (COMPUTER_INFO_QR_STAGE_TIMING)
+
+#if !defined (MDE_CPU_IA32) && !defined (MDE_CPU_X64)
+#error "COMPUTER_INFO_QR_STAGE_TIMING needs a time stamp counter."
+#endif
+
+typedef enum {
+  QrStageSegment,
+  QrStageDataCodewords,
+  QrStageReedSolomon,
+  QrStageInterleave,
+  QrStagePlacement,
+  QrStageMask,
+  QrStagePenalty,
+  QrStageCount
+} QR_STAGE;
+
+STATIC UINT64 mQrStageTicks[QrStageCount];
+
+#define QR_STAGE_BEGIN(Stage)  UINT64 QrStageStart##Stage = AsmReadTsc()
+#define QR_STAGE_END(Stage)    mQrStageTicks[QrStage##Stage] += AsmReadTsc() - QrStageStart##Stage
+
+#else
+
+#define QR_STAGE_BEGIN(Stage)
+#define QR_STAGE_END(Stage)
+
+#endif
+
+//
+// Big-endian bit writer. Bits are collected in a 64-bit accumulator and only
+// complete bytes are stored, so fewer than eight bits are ever pending
+// between calls.
+//
 typedef struct {
-  UINT8 Bytes[COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH];
-  UINTN BitLength;
-  UINTN CapacityBytes;
+  UINT8  *Bytes;
+  UINTN  CapacityBytes;
+  UINTN  ByteLength;
+  UINT64 Accumulator;
+  UINTN  PendingBits;
 } QR_BIT_BUFFER;
 
-typedef INT8    QR_MODULE_MATRIX[COMPUTER_INFO_QR_MAX_SIZE][COMPUTER_INFO_QR_MAX_SIZE];
-typedef BOOLEAN QR_FUNCTION_MATRIX[COMPUTER_INFO_QR_MAX_SIZE][COMPUTER_INFO_QR_MAX_SIZE];
-
-STATIC CONST UINT8 mEccCodewordsPerBlock[COMPUTER_INFO_QR_MAX_VERSION + 1] = {
-  0,  7, 10, 15, 20, 26, 18, 20, 24, 30, 18, 20, 24, 26, 30, 22, 24, 28, 30, 28, 28, 28, 28, 30
-};
+#define QR_ROW_WORDS  COMPUTER_INFO_QR_ROW_WORDS
+#define QR_MASK_COUNT 8
 
-STATIC CONST UINT8 mNumErrorCorrectionBlocks[COMPUTER_INFO_QR_MAX_VERSION + 1] = {
-  0, 1, 1, 1, 1, 1, 2, 2, 2, 2, 4, 4, 4, 4, 4, 6, 6, 6, 6, 7, 8, 8, 9, 9
-};
+typedef UINT64 QR_MODULE_MATRIX[COMPUTER_INFO_QR_MAX_SIZE][QR_ROW_WORDS];
+typedef UINT64 QR_FUNCTION_MATRIX[COMPUTER_INFO_QR_MAX_SIZE][QR_ROW_WORDS];
 
-STATIC UINT8   mGaloisExpTable[GF_SIZE * 2];
-STATIC UINT8   mGaloisLogTable[GF_SIZE];
-STATIC BOOLEAN mGaloisTablesReady = FALSE;
+STATIC
+BOOLEAN
+QrMatrixGet(
+  IN CONST UINT64 Matrix[][QR_ROW_WORDS],
+  IN UINTN        X,
+  IN UINTN        Y
+  )
+{
+  return (BOOLEAN)((Matrix[Y][X / 64] >> (X % 64)) & 0x1);
+}
 
 STATIC
 VOID
-InitializeGaloisTables(
-  VOID
+QrMatrixSet(
+  IN OUT UINT64  Matrix[][QR_ROW_WORDS],
+  IN     UINTN   X,
+  IN     UINTN   Y,
+  IN     BOOLEAN Value
   )
 {
-  if (mGaloisTablesReady) {
-    return;
-  }
-
-  UINT16 Value = 1;
-  for (UINTN Index = 0; Index < GF_SIZE - 1; Index++) {
-    mGaloisExpTable[Index] = (UINT8)Value;
-    mGaloisLogTable[Value] = (UINT8)Index;
-    Value <<= 1;
-    if (Value & GF_SIZE) {
-      Value ^= GF_GENERATOR_POLYNOMIAL;
-    }
-  }
-
-  for (UINTN Index = GF_SIZE - 1; Index < GF_SIZE * 2; Index++) {
-    mGaloisExpTable[Index] = mGaloisExpTable[Index - (GF_SIZE - 1)];
+  UINT64 Bit = (UINT64)1 << (X % 64);
+  if (Value) {
+    Matrix[Y][X / 64] |= Bit;
+  } else {
+    Matrix[Y][X / 64] &= ~Bit;
   }
+}
 
-  mGaloisTablesReady = TRUE;
+STATIC
+VOID
+QrSetFunctionModule(
+  IN OUT UINT64  Modules[][QR_ROW_WORDS],
+  IN OUT UINT64  FunctionModules[][QR_ROW_WORDS],
+  IN     UINTN   X,
+  IN     UINTN   Y,
+  IN     BOOLEAN Value
+  )
+{
+  QrMatrixSet(Modules, X, Y, Value);
+  QrMatrixSet(FunctionModules, X, Y, TRUE);
 }
 
 STATIC
-UINT8
-GaloisMultiply(
-  IN UINT8 A,
-  IN UINT8 B
+UINTN
+QrRowWords(
+  IN UINTN Size
   )
 {
-  if (A == 0 || B == 0) {
-    return 0;
-  }
+  return (Size + 63) / 64;
+}
 
-  UINTN LogSum = mGaloisLogTable[A] + mGaloisLogTable[B];
-  return mGaloisExpTable[LogSum % (GF_SIZE - 1)];
+STATIC
+VOID
+QrMatrixCopy(
+  OUT UINT64       Destination[][QR_ROW_WORDS],
+  IN  CONST UINT64 Source[][QR_ROW_WORDS],
+  IN  UINTN        Size
+  )
+{
+  CopyMem(Destination, Source, Size * sizeof(Source[0]));
 }
 
 STATIC
-UINT8
-GaloisPowerOfTwo(
-  IN UINTN Exponent
+UINTN
+QrPopCount64(
+  IN UINT64 Value
   )
 {
-  return mGaloisExpTable[Exponent % (GF_SIZE - 1)];
+  Value = Value - ((Value >> 1) & 0x5555555555555555ULL);
+  Value = (Value & 0x3333333333333333ULL) + ((Value >> 2) & 0x3333333333333333ULL);
+  Value = (Value + (Value >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return (UINTN)((Value * 0x0101010101010101ULL) >> 56);
 }
 
 STATIC
@@ -112,53 +176,45 @@ GetTotalCodewords(
   return GetNumRawDataModules(Version) / 8;
 }
 
-STATIC
-UINTN
-GetRemainderBits(
-  IN UINTN Version
-  )
-{
-  return GetNumRawDataModules(Version) % 8;
-}
-
 STATIC
 UINTN
 GetEccCodewordsPerBlock(
-  IN UINTN Version
+  IN UINTN Version,
+  IN UINTN Level
   )
 {
-  if (Version > COMPUTER_INFO_QR_MAX_VERSION) {
+  if ((Version > COMPUTER_INFO_QR_MAX_VERSION) || (Level >= QR_TABLES_LEVEL_COUNT)) {
     return 0;
   }
-  return mEccCodewordsPerBlock[Version];
+  return mEccCodewordsPerBlock[Level][Version];
 }
 
 STATIC
 UINTN
 GetNumErrorCorrectionBlocks(
-  IN UINTN Version
+  IN UINTN Version,
+  IN UINTN Level
   )
 {
-  if (Version > COMPUTER_INFO_QR_MAX_VERSION) {
+  if ((Version > COMPUTER_INFO_QR_MAX_VERSION) || (Level >= QR_TABLES_LEVEL_COUNT)) {
     return 0;
   }
-  return mNumErrorCorrectionBlocks[Version];
+  return mNumErrorCorrectionBlocks[Level][Version];
 }
 
 STATIC
 UINTN
 GetDataCodewordCapacity(
-  IN UINTN Version
+  IN UINTN Version,
+  IN UINTN Level
   )
 {
-  UINTN Total = GetTotalCodewords(Version);
-  UINTN EccPerBlock = GetEccCodewordsPerBlock(Version);
-  UINTN NumBlocks = GetNumErrorCorrectionBlocks(Version);
-  if ((Total == 0) || (EccPerBlock == 0) || (NumBlocks == 0)) {
+  if ((Version < COMPUTER_INFO_QR_MIN_VERSION) || (Version > COMPUTER_INFO_QR_MAX_VERSION) ||
+      (Level >= QR_TABLES_LEVEL_COUNT)) {
     return 0;
   }
 
-  return Total - (EccPerBlock * NumBlocks);
+  return mDataCodewordCapacity[Level][Version];
 }
 
 STATIC
@@ -210,17 +266,17 @@ GetAlignmentPatternCenters(
   *Count = Index + 1;
 }
 
+//
+// Appends the 12-bit BCH remainder for generator 0x1F25 to six data bits.
+// QR version information and rMQR format information both use this code.
+//
 STATIC
 UINT32
-ComputeVersionInformation(
-  IN UINTN Version
+ComputeBchCode18(
+  IN UINT32 Data
   )
 {
-  if (Version < 7) {
-    return 0;
-  }
-
-  UINT32 Remainder = (UINT32)Version;
+  UINT32 Remainder = Data;
   for (UINTN Index = 0; Index < 12; Index++) {
     if ((Remainder >> 11) & 0x1) {
       Remainder = (Remainder << 1) ^ 0x1F25;
@@ -229,19 +285,44 @@ ComputeVersionInformation(
     }
   }
 
-  return ((UINT32)Version << 12) | (Remainder & 0xFFF);
+  return (Data << 12) | (Remainder & 0xFFF);
+}
+
+STATIC
+UINT32
+ComputeVersionInformation(
+  IN UINTN Version
+  )
+{
+  if (Version < 7) {
+    return 0;
+  }
+
+  return ComputeBchCode18((UINT32)Version);
 }
 
 STATIC
 VOID
 BitBufferInit(
   OUT QR_BIT_BUFFER *Buffer,
+  OUT UINT8         *Bytes,
   IN  UINTN          CapacityBytes
   )
 {
-  ZeroMem(Buffer->Bytes, sizeof(Buffer->Bytes));
-  Buffer->BitLength = 0;
+  Buffer->Bytes = Bytes;
   Buffer->CapacityBytes = CapacityBytes;
+  Buffer->ByteLength = 0;
+  Buffer->Accumulator = 0;
+  Buffer->PendingBits = 0;
+}
+
+STATIC
+UINTN
+BitBufferLength(
+  IN CONST QR_BIT_BUFFER *Buffer
+  )
+{
+  return (Buffer->ByteLength * 8) + Buffer->PendingBits;
 }
 
 STATIC
@@ -256,956 +337,3090 @@ BitBufferAppendBits(
     return EFI_SUCCESS;
   }
 
-  if (Count > 24) {
+  if (Count > 32) {
     return EFI_INVALID_PARAMETER;
   }
 
-  for (INTN Bit = (INTN)Count - 1; Bit >= 0; Bit--) {
-    UINTN ByteIndex = Buffer->BitLength / 8;
-    if (ByteIndex >= Buffer->CapacityBytes) {
-      return EFI_BUFFER_TOO_SMALL;
-    }
+  if (BitBufferLength(Buffer) + Count > Buffer->CapacityBytes * 8) {
+    return EFI_BUFFER_TOO_SMALL;
+  }
 
-    UINTN BitOffset = 7 - (Buffer->BitLength % 8);
-    UINT8 Mask = (UINT8)((Value >> Bit) & 0x1);
-    Buffer->Bytes[ByteIndex] |= (UINT8)(Mask << BitOffset);
-    Buffer->BitLength++;
+  Buffer->Accumulator = (Buffer->Accumulator << Count) | (Value & (MAX_UINT32 >> (32 - Count)));
+  Buffer->PendingBits += Count;
+
+  while (Buffer->PendingBits >= 8) {
+    Buffer->PendingBits -= 8;
+    Buffer->Bytes[Buffer->ByteLength++] = (UINT8)(Buffer->Accumulator >> Buffer->PendingBits);
   }
 
   return EFI_SUCCESS;
 }
 
+//
+// Appends whole bytes at the current bit offset. When the writer is byte
+// aligned this is a plain copy; otherwise eight source bytes at a time are
+// loaded as one big-endian word and shifted right by the pending bit count,
+// with the bits shifted out carried into the next word.
+//
 STATIC
 EFI_STATUS
-BuildDataCodewords(
-  IN  CONST UINT8 *Payload,
-  IN  UINTN        PayloadLength,
-  OUT UINT8       *Codewords,
-  IN  UINTN        DataCapacity,
-  IN  UINTN        CharCountBits
+BitBufferAppendBytes(
+  IN OUT QR_BIT_BUFFER *Buffer,
+  IN CONST UINT8       *Data,
+  IN UINTN              Length
   )
 {
-  if ((PayloadLength > DataCapacity) || (DataCapacity == 0) ||
-      (DataCapacity > COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH)) {
-    return EFI_BAD_BUFFER_SIZE;
+  if (BitBufferLength(Buffer) + (Length * 8) > Buffer->CapacityBytes * 8) {
+    return EFI_BUFFER_TOO_SMALL;
   }
 
-  if ((CharCountBits != 8) && (CharCountBits != 16)) {
-    return EFI_INVALID_PARAMETER;
+  UINTN Shift = Buffer->PendingBits;
+  if (Shift == 0) {
+    CopyMem(&Buffer->Bytes[Buffer->ByteLength], Data, Length);
+    Buffer->ByteLength += Length;
+    return EFI_SUCCESS;
   }
 
-  if (PayloadLength >= (1ULL << CharCountBits)) {
-    return EFI_BAD_BUFFER_SIZE;
+  UINT8  *Output = &Buffer->Bytes[Buffer->ByteLength];
+  UINT64 Carry = Buffer->Accumulator << (64 - Shift);
+  UINTN  Index = 0;
+
+  for (; Index + 8 <= Length; Index += 8) {
+    UINT64 Word = SwapBytes64(ReadUnaligned64((CONST UINT64 *)&Data[Index]));
+    WriteUnaligned64((UINT64 *)&Output[Index], SwapBytes64(Carry | (Word >> Shift)));
+    Carry = Word << (64 - Shift);
   }
 
-  QR_BIT_BUFFER Buffer;
-  BitBufferInit(&Buffer, DataCapacity);
+  Buffer->ByteLength += Index;
+  Buffer->Accumulator = Carry >> (64 - Shift);
 
-  UINTN DataBitCapacity = DataCapacity * 8;
+  for (; Index < Length; Index++) {
+    BitBufferAppendBits(Buffer, Data[Index], 8);
+  }
 
-  EFI_STATUS Status;
+  return EFI_SUCCESS;
+}
 
-  Status = BitBufferAppendBits(&Buffer, 0x4, 4);
-  if (EFI_ERROR(Status)) {
-    return Status;
-  }
+//
+// Fills the rest of a byte-aligned buffer with the alternating 0xEC/0x11 pad
+// codewords.
+//
+STATIC
+VOID
+BitBufferAppendPadding(
+  IN OUT QR_BIT_BUFFER *Buffer
+  )
+{
+  UINTN Remaining = Buffer->CapacityBytes - Buffer->ByteLength;
+  UINT8 *Output = &Buffer->Bytes[Buffer->ByteLength];
 
-  Status = BitBufferAppendBits(&Buffer, (UINT32)PayloadLength, CharCountBits);
-  if (EFI_ERROR(Status)) {
-    return Status;
+  SetMem(Output, Remaining, 0xEC);
+  for (UINTN Index = 1; Index < Remaining; Index += 2) {
+    Output[Index] = 0x11;
   }
 
-  for (UINTN Index = 0; Index < PayloadLength; Index++) {
-    Status = BitBufferAppendBits(&Buffer, Payload[Index], 8);
-    if (EFI_ERROR(Status)) {
-      return Status;
-    }
-  }
+  Buffer->ByteLength = Buffer->CapacityBytes;
+}
 
-  if (Buffer.BitLength > DataBitCapacity) {
-    return EFI_BAD_BUFFER_SIZE;
-  }
+//
+// Data segments. The payload is split into numeric, alphanumeric and byte
+// segments; each costs a 4-bit mode indicator plus a character count whose
+// width depends on the mode and the version group (1-9, 10-26, 27-40).
+//
+#define QR_MODE_NUMERIC       0x1
+#define QR_MODE_ALPHANUMERIC  0x2
+#define QR_MODE_BYTE          0x4
 
-  UINTN RemainingBits = DataBitCapacity - Buffer.BitLength;
-  UINTN TerminatorBits = (RemainingBits < 4) ? RemainingBits : 4;
+typedef struct {
+  UINT8  Mode;
+  UINT16 Offset;
+  UINT16 Length;
+} QR_SEGMENT;
+
+STATIC CONST UINT8 mCharCountBits[3][3] = {
+  { 10, 12, 14 },   // Numeric
+  { 9,  11, 13 },   // Alphanumeric
+  { 8,  16, 16 }    // Byte
+};
 
-  Status = BitBufferAppendBits(&Buffer, 0, TerminatorBits);
-  if (EFI_ERROR(Status)) {
-    return Status;
-  }
+STATIC
+UINTN
+GetCharCountBits(
+  IN UINTN Mode,
+  IN UINTN Version
+  )
+{
+  UINTN Group = (Version <= 9) ? 0 : ((Version <= 26) ? 1 : 2);
 
-  if ((Buffer.BitLength % 8) != 0) {
-    Status = BitBufferAppendBits(&Buffer, 0, 8 - (Buffer.BitLength % 8));
-    if (EFI_ERROR(Status)) {
-      return Status;
-    }
+  switch (Mode) {
+    case QR_MODE_NUMERIC:
+      return mCharCountBits[0][Group];
+    case QR_MODE_ALPHANUMERIC:
+      return mCharCountBits[1][Group];
+    default:
+      return mCharCountBits[2][Group];
   }
+}
 
-  BOOLEAN Toggle = TRUE;
-  while (Buffer.BitLength < DataBitCapacity) {
-    UINT8 Pad = Toggle ? 0xEC : 0x11;
-    Status = BitBufferAppendBits(&Buffer, Pad, 8);
-    if (EFI_ERROR(Status)) {
-      return Status;
-    }
-    Toggle = !Toggle;
+STATIC
+INTN
+GetAlphanumericValue(
+  IN UINT8 Character
+  )
+{
+  if ((Character >= '0') && (Character <= '9')) {
+    return Character - '0';
+  }
+
+  if ((Character >= 'A') && (Character <= 'Z')) {
+    return Character - 'A' + 10;
+  }
+
+  switch (Character) {
+    case ' ':
+      return 36;
+    case '$':
+      return 37;
+    case '%':
+      return 38;
+    case '*':
+      return 39;
+    case '+':
+      return 40;
+    case '-':
+      return 41;
+    case '.':
+      return 42;
+    case '/':
+      return 43;
+    case ':':
+      return 44;
+    default:
+      return -1;
   }
-
-  CopyMem(Codewords, Buffer.Bytes, DataCapacity);
-  return EFI_SUCCESS;
 }
 
+//
+// Bit-minimal segmentation by dynamic programming over the payload. Numeric
+// data costs 4, 3, 3 bits for the first, second and third digit of every
+// group of three and alphanumeric data 6, 5 bits for the two characters of a
+// pair, so tracking the position inside the current group makes every
+// per-character cost exact. The states are numeric with 1, 2 or 0 digits
+// pending modulo 3, alphanumeric with 1 or 0 characters pending modulo 2,
+// and byte. Trace records, per character and state, the state it was
+// reached from and whether a new segment started there.
+//
+#define QR_STATE_NUMERIC_1       0
+#define QR_STATE_NUMERIC_2       1
+#define QR_STATE_NUMERIC_0       2
+#define QR_STATE_ALPHANUMERIC_1  3
+#define QR_STATE_ALPHANUMERIC_0  4
+#define QR_STATE_BYTE            5
+#define QR_STATE_COUNT           6
+#define QR_STATE_NEW_SEGMENT     0x80
+
+#define QR_COST_INFINITE  MAX_UINT32
+
+typedef UINT8 QR_SEGMENT_TRACE[QR_STATE_COUNT];
+
 STATIC
 VOID
-ComputeGeneratorPolynomial(
-  IN  UINTN Degree,
-  OUT UINT8 *Result
+RelaxSegmentState(
+  IN OUT UINT32 *Cost,
+  IN OUT UINT8  *Trace,
+  IN     UINT32 PreviousCost,
+  IN     UINT8  From,
+  IN     UINT32 Increment
   )
 {
-  SetMem(Result, (Degree + 1) * sizeof(UINT8), 0);
-  Result[0] = 1;
-
-  for (UINTN D = 0; D < Degree; D++) {
-    UINT8 Factor = GaloisPowerOfTwo(D);
-    Result[D + 1] = 0;
-    for (INTN Index = (INTN)D + 1; Index > 0; Index--) {
-      UINT8 Current = Result[Index];
-      UINT8 Product = GaloisMultiply(Result[Index - 1], Factor);
-      Result[Index] = Current ^ Product;
-    }
+  if ((PreviousCost != QR_COST_INFINITE) && (PreviousCost + Increment < *Cost)) {
+    *Cost  = PreviousCost + Increment;
+    *Trace = From;
   }
 }
 
+//
+// Segment header bits (mode indicator plus character count) for numeric,
+// alphanumeric and byte segments in the given version.
+//
 STATIC
 VOID
-ComputeReedSolomon(
-  IN  CONST UINT8 *Data,
-  IN  UINTN        DataCount,
-  OUT UINT8       *Parity,
-  IN  UINTN        ParityCount
+GetSegmentHeaderBits(
+  IN  UINTN   Version,
+  OUT UINT32 *HeaderBits
+  )
+{
+  HeaderBits[0] = (UINT32)(4 + GetCharCountBits(QR_MODE_NUMERIC, Version));
+  HeaderBits[1] = (UINT32)(4 + GetCharCountBits(QR_MODE_ALPHANUMERIC, Version));
+  HeaderBits[2] = (UINT32)(4 + GetCharCountBits(QR_MODE_BYTE, Version));
+}
+
+//
+// Advances the segmentation DP by one character: Next and From receive the
+// state costs and trace after Character, given the costs in Cost before it.
+//
+STATIC
+VOID
+AdvanceSegmentStates(
+  IN  CONST UINT32 *Cost,
+  OUT UINT32       *Next,
+  OUT UINT8        *From,
+  IN  UINT8         Character,
+  IN  CONST UINT32 *HeaderBits,
+  IN  BOOLEAN       First
   )
 {
-  SetMem(Parity, ParityCount * sizeof(UINT8), 0);
+  //
+  // Starting a new segment may follow any state; the first character can
+  // only start one.
+  //
+  UINT32 BestCost  = 0;
+  UINT8  BestState = 0;
+  if (!First) {
+    BestCost = QR_COST_INFINITE;
+    for (UINTN State = 0; State < QR_STATE_COUNT; State++) {
+      if (Cost[State] < BestCost) {
+        BestCost  = Cost[State];
+        BestState = (UINT8)State;
+      }
+    }
+  }
 
-  UINT8 Generator[COMPUTER_INFO_QR_MAX_ECC_CODEWORDS_PER_BLOCK + 1];
-  ComputeGeneratorPolynomial(ParityCount, Generator);
+  BestState |= QR_STATE_NEW_SEGMENT;
 
-  for (UINTN Index = 0; Index < DataCount; Index++) {
-    UINT8 Factor = Data[Index] ^ Parity[0];
+  for (UINTN State = 0; State < QR_STATE_COUNT; State++) {
+    Next[State] = QR_COST_INFINITE;
+    From[State] = 0;
+  }
 
-    for (UINTN Shift = 0; Shift < ParityCount - 1; Shift++) {
-      Parity[Shift] = Parity[Shift + 1];
-    }
-    Parity[ParityCount - 1] = 0;
+  if ((Character >= '0') && (Character <= '9')) {
+    RelaxSegmentState(&Next[QR_STATE_NUMERIC_1], &From[QR_STATE_NUMERIC_1], Cost[QR_STATE_NUMERIC_0], QR_STATE_NUMERIC_0, 4);
+    RelaxSegmentState(&Next[QR_STATE_NUMERIC_1], &From[QR_STATE_NUMERIC_1], BestCost, BestState, HeaderBits[0] + 4);
+    RelaxSegmentState(&Next[QR_STATE_NUMERIC_2], &From[QR_STATE_NUMERIC_2], Cost[QR_STATE_NUMERIC_1], QR_STATE_NUMERIC_1, 3);
+    RelaxSegmentState(&Next[QR_STATE_NUMERIC_0], &From[QR_STATE_NUMERIC_0], Cost[QR_STATE_NUMERIC_2], QR_STATE_NUMERIC_2, 3);
+  }
 
-    for (UINTN GenIndex = 0; GenIndex < ParityCount; GenIndex++) {
-      UINT8 GeneratorCoeff = Generator[GenIndex + 1];
-      UINT8 Product = GaloisMultiply(GeneratorCoeff, Factor);
-      Parity[GenIndex] ^= Product;
-    }
+  if (GetAlphanumericValue(Character) >= 0) {
+    RelaxSegmentState(&Next[QR_STATE_ALPHANUMERIC_1], &From[QR_STATE_ALPHANUMERIC_1], Cost[QR_STATE_ALPHANUMERIC_0], QR_STATE_ALPHANUMERIC_0, 6);
+    RelaxSegmentState(&Next[QR_STATE_ALPHANUMERIC_1], &From[QR_STATE_ALPHANUMERIC_1], BestCost, BestState, HeaderBits[1] + 6);
+    RelaxSegmentState(&Next[QR_STATE_ALPHANUMERIC_0], &From[QR_STATE_ALPHANUMERIC_0], Cost[QR_STATE_ALPHANUMERIC_1], QR_STATE_ALPHANUMERIC_1, 5);
   }
+
+  RelaxSegmentState(&Next[QR_STATE_BYTE], &From[QR_STATE_BYTE], Cost[QR_STATE_BYTE], QR_STATE_BYTE, 8);
+  RelaxSegmentState(&Next[QR_STATE_BYTE], &From[QR_STATE_BYTE], BestCost, BestState, HeaderBits[2] + 8);
 }
 
+//
+// Segments the payload for the given header bits per mode and returns the
+// total bit count.
+//
 STATIC
-EFI_STATUS
-BuildCodewordSequence(
-  IN  CONST UINT8 *DataCodewords,
-  IN  UINTN        DataCodewordCount,
-  IN  UINTN        TotalCodewords,
-  IN  UINTN        NumBlocks,
-  IN  UINTN        EccCodewordsPerBlock,
-  OUT UINT8       *Codewords
+UINTN
+ComputeOptimalSegmentsForHeaders(
+  IN  CONST UINT8      *Payload,
+  IN  UINTN             PayloadLength,
+  IN  CONST UINT32     *HeaderBits,
+  OUT QR_SEGMENT_TRACE *Trace,
+  OUT QR_SEGMENT       *Segments,
+  OUT UINTN            *SegmentCount
   )
 {
-  EFI_STATUS Status;
-  UINT8 (*Blocks)[COMPUTER_INFO_QR_MAX_TOTAL_CODEWORDS] = NULL;
-  UINTN *BlockLengths = NULL;
-  UINT8 *Parity = NULL;
+  UINT32 Cost[QR_STATE_COUNT];
 
-  if ((DataCodewords == NULL) || (Codewords == NULL) ||
-      (NumBlocks == 0) || (EccCodewordsPerBlock == 0) ||
-      (NumBlocks > COMPUTER_INFO_QR_MAX_ERROR_CORRECTION_BLOCKS) ||
-      (EccCodewordsPerBlock > COMPUTER_INFO_QR_MAX_ECC_CODEWORDS_PER_BLOCK) ||
-      (TotalCodewords > COMPUTER_INFO_QR_MAX_TOTAL_CODEWORDS) ||
-      (DataCodewordCount > COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH)) {
-    return EFI_INVALID_PARAMETER;
+  for (UINTN State = 0; State < QR_STATE_COUNT; State++) {
+    Cost[State] = QR_COST_INFINITE;
   }
 
-  UINTN RawCodewords = TotalCodewords;
-  UINTN NumLongBlocks = RawCodewords % NumBlocks;
-  UINTN NumShortBlocks = NumBlocks - NumLongBlocks;
-  UINTN ShortBlockTotalLength = RawCodewords / NumBlocks;
-  UINTN LongBlockTotalLength = ShortBlockTotalLength + ((NumLongBlocks > 0) ? 1 : 0);
+  for (UINTN Index = 0; Index < PayloadLength; Index++) {
+    UINT32 Next[QR_STATE_COUNT];
 
-  if (ShortBlockTotalLength < EccCodewordsPerBlock) {
-    return EFI_BAD_BUFFER_SIZE;
+    AdvanceSegmentStates(Cost, Next, Trace[Index], Payload[Index], HeaderBits, (BOOLEAN)(Index == 0));
+    CopyMem(Cost, Next, sizeof(Cost));
   }
 
-  UINTN ShortBlockDataLength = ShortBlockTotalLength - EccCodewordsPerBlock;
-  UINTN LongBlockDataLength = LongBlockTotalLength - EccCodewordsPerBlock;
-
-  UINTN ExpectedDataCodewords = (ShortBlockDataLength * NumShortBlocks) + (LongBlockDataLength * NumLongBlocks);
-  if (ExpectedDataCodewords != DataCodewordCount) {
-    return EFI_BAD_BUFFER_SIZE;
+  UINTN State = QR_STATE_BYTE;
+  for (UINTN Candidate = 0; Candidate < QR_STATE_COUNT; Candidate++) {
+    if (Cost[Candidate] < Cost[State]) {
+      State = Candidate;
+    }
   }
 
-  Blocks = AllocateZeroPool(NumBlocks * sizeof(Blocks[0]));
-  if (Blocks == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Cleanup;
-  }
+  UINTN TotalBits = (PayloadLength == 0) ? 0 : Cost[State];
+
+  //
+  // Walk the trace backwards, emitting segments last to first, then restore
+  // payload order.
+  //
+  UINTN Count = 0;
+  UINTN End = PayloadLength;
+  for (UINTN Index = PayloadLength; Index > 0; Index--) {
+    UINT8 Step = Trace[Index - 1][State];
+    if ((Step & QR_STATE_NEW_SEGMENT) != 0) {
+      Segments[Count].Mode   = (State <= QR_STATE_NUMERIC_0) ? QR_MODE_NUMERIC :
+                               ((State == QR_STATE_BYTE) ? QR_MODE_BYTE : QR_MODE_ALPHANUMERIC);
+      Segments[Count].Offset = (UINT16)(Index - 1);
+      Segments[Count].Length = (UINT16)(End - (Index - 1));
+      Count++;
+      End = Index - 1;
+    }
 
-  BlockLengths = AllocateZeroPool(NumBlocks * sizeof(BlockLengths[0]));
-  if (BlockLengths == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Cleanup;
+    State = Step & ~QR_STATE_NEW_SEGMENT;
   }
 
-  Parity = AllocateZeroPool(EccCodewordsPerBlock * sizeof(UINT8));
-  if (Parity == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Cleanup;
+  for (UINTN Index = 0; Index < Count / 2; Index++) {
+    QR_SEGMENT Swap = Segments[Index];
+    Segments[Index] = Segments[Count - 1 - Index];
+    Segments[Count - 1 - Index] = Swap;
   }
 
-  UINTN Offset = 0;
-  for (UINTN BlockIndex = 0; BlockIndex < NumBlocks; BlockIndex++) {
-    BOOLEAN IsShortBlock = (BlockIndex < NumShortBlocks);
-    UINTN   DataLength   = IsShortBlock ? ShortBlockDataLength : LongBlockDataLength;
-
-    CopyMem(Blocks[BlockIndex], DataCodewords + Offset, DataLength);
-    Offset += DataLength;
+  *SegmentCount = Count;
+  return TotalBits;
+}
 
-    ComputeReedSolomon(
-      Blocks[BlockIndex],
-      DataLength,
-      Parity,
-      EccCodewordsPerBlock
-      );
+STATIC
+UINTN
+ComputeOptimalSegments(
+  IN  CONST UINT8      *Payload,
+  IN  UINTN             PayloadLength,
+  IN  UINTN             Version,
+  OUT QR_SEGMENT_TRACE *Trace,
+  OUT QR_SEGMENT       *Segments,
+  OUT UINTN            *SegmentCount
+  )
+{
+  UINT32 HeaderBits[3];
 
-    UINTN InsertIndex = DataLength;
-    if (IsShortBlock) {
-      Blocks[BlockIndex][InsertIndex++] = 0;
-    }
+  GetSegmentHeaderBits(Version, HeaderBits);
+  return ComputeOptimalSegmentsForHeaders(Payload, PayloadLength, HeaderBits, Trace, Segments, SegmentCount);
+}
 
-    CopyMem(&Blocks[BlockIndex][InsertIndex], Parity, EccCodewordsPerBlock);
-    BlockLengths[BlockIndex] = InsertIndex + EccCodewordsPerBlock;
-  }
+//
+// Picks the smallest version whose data capacity holds the optimal
+// segmentation. Character count widths only change between version groups,
+// so the payload is segmented once per group and the version is then found by
+// binary search over that group's slice of mDataCodewordCapacity.
+//
+// A fixed EccLevel is searched directly. AutoBoost searches at level Low and
+// then raises the level while the chosen version still holds the bits.
+//
+STATIC
+UINTN
+SelectVersionAndSegments(
+  IN  CONST UINT8                *Payload,
+  IN  UINTN                       PayloadLength,
+  IN  COMPUTER_INFO_QR_ECC_LEVEL  EccLevel,
+  OUT QR_SEGMENT_TRACE           *Trace,
+  OUT QR_SEGMENT                 *Segments,
+  OUT UINTN                      *SegmentCount,
+  OUT UINTN                      *Level
+  )
+{
+  UINTN Version = COMPUTER_INFO_QR_MIN_VERSION;
+  UINTN SearchLevel = (EccLevel == ComputerInfoQrEccAutoBoost) ? ComputerInfoQrEccLow : (UINTN)EccLevel;
 
-  if (Offset != DataCodewordCount) {
-    Status = EFI_BAD_BUFFER_SIZE;
-    goto Cleanup;
+  if (SearchLevel >= QR_TABLES_LEVEL_COUNT) {
+    return 0;
   }
 
-  UINTN BlockLength = BlockLengths[0];
-  UINTN CodewordIndex = 0;
+  while (Version <= COMPUTER_INFO_QR_MAX_VERSION) {
+    UINTN GroupEnd = (Version <= 9) ? 9 : ((Version <= 26) ? 26 : 40);
+    if (GroupEnd > COMPUTER_INFO_QR_MAX_VERSION) {
+      GroupEnd = COMPUTER_INFO_QR_MAX_VERSION;
+    }
 
-  for (UINTN Index = 0; Index < BlockLength; Index++) {
-    for (UINTN BlockIndex = 0; BlockIndex < NumBlocks; BlockIndex++) {
-      if ((BlockIndex < NumShortBlocks) && (Index == ShortBlockDataLength)) {
-        continue;
+    UINTN Bits = ComputeOptimalSegments(Payload, PayloadLength, Version, Trace, Segments, SegmentCount);
+    if (Bits <= GetDataCodewordCapacity(GroupEnd, SearchLevel) * 8) {
+      UINTN Low = Version;
+      UINTN High = GroupEnd;
+      while (Low < High) {
+        UINTN Middle = Low + ((High - Low) / 2);
+        if (Bits <= GetDataCodewordCapacity(Middle, SearchLevel) * 8) {
+          High = Middle;
+        } else {
+          Low = Middle + 1;
+        }
       }
 
-      if (Index < BlockLengths[BlockIndex]) {
-        Codewords[CodewordIndex++] = Blocks[BlockIndex][Index];
+      if (EccLevel == ComputerInfoQrEccAutoBoost) {
+        while ((SearchLevel + 1 < QR_TABLES_LEVEL_COUNT) &&
+               (Bits <= GetDataCodewordCapacity(Low, SearchLevel + 1) * 8)) {
+          SearchLevel++;
+        }
       }
+
+      *Level = SearchLevel;
+      return Low;
     }
+
+    Version = GroupEnd + 1;
   }
 
-  if (CodewordIndex != TotalCodewords) {
-    Status = EFI_BAD_BUFFER_SIZE;
-    goto Cleanup;
+  return 0;
+}
+
+//
+// rMQR segments use 3-bit mode indicators and per-version character count
+// widths.
+//
+#define RMQR_MODE_INDICATOR_BITS  3
+
+STATIC
+VOID
+GetRmqrSegmentHeaderBits(
+  IN  UINTN   Version,
+  OUT UINT32 *HeaderBits
+  )
+{
+  for (UINTN Mode = 0; Mode < 3; Mode++) {
+    HeaderBits[Mode] = RMQR_MODE_INDICATOR_BITS + mRmqrVersions[Version].CharCountBits[Mode];
   }
+}
 
-  Status = EFI_SUCCESS;
+//
+// Picks the rMQR version as EncodeComputerInfoQrRmqr describes. Character
+// count widths do not grow with the version indicator, so the payload is
+// segmented for every version rather than searched; there are only 32, and
+// rMQR payloads are short. Version is the version indicator, Level 0 for
+// Medium and 1 for High.
+//
+STATIC
+EFI_STATUS
+SelectRmqrVersionAndSegments(
+  IN  CONST UINT8                *Payload,
+  IN  UINTN                       PayloadLength,
+  IN  COMPUTER_INFO_QR_ECC_LEVEL  EccLevel,
+  IN  UINTN                       AreaWidth,
+  IN  UINTN                       AreaHeight,
+  IN  UINTN                       QuietZone,
+  OUT QR_SEGMENT_TRACE           *Trace,
+  OUT QR_SEGMENT                 *Segments,
+  OUT UINTN                      *SegmentCount,
+  OUT UINTN                      *Version,
+  OUT UINTN                      *Level
+  )
+{
+  UINT32 HeaderBits[3];
+  UINTN  SearchLevel = ((EccLevel == ComputerInfoQrEccQuartile) || (EccLevel == ComputerInfoQrEccHigh)) ? 1 : 0;
+  UINTN  BestVersion = RMQR_TABLES_VERSION_COUNT;
+  UINTN  BestFit     = 0;
+  UINTN  BestModules = 0;
+
+  for (UINTN Candidate = 0; Candidate < RMQR_TABLES_VERSION_COUNT; Candidate++) {
+    CONST RMQR_VERSION_INFO *Info = &mRmqrVersions[Candidate];
+
+    GetRmqrSegmentHeaderBits(Candidate, HeaderBits);
+    UINTN Bits = ComputeOptimalSegmentsForHeaders(Payload, PayloadLength, HeaderBits, Trace, Segments, SegmentCount);
+    if (Bits > (UINTN)mRmqrDataCodewordCapacity[SearchLevel][Candidate] * 8) {
+      continue;
+    }
 
-Cleanup:
-  if (Parity != NULL) {
-    FreePool(Parity);
+    UINTN Fit     = MIN(AreaWidth / (Info->Width + (2 * QuietZone)), AreaHeight / (Info->Height + (2 * QuietZone)));
+    UINTN Modules = (UINTN)Info->Width * Info->Height;
+    if ((BestVersion == RMQR_TABLES_VERSION_COUNT) || (Fit > BestFit) || ((Fit == BestFit) && (Modules < BestModules))) {
+      BestVersion = Candidate;
+      BestFit     = Fit;
+      BestModules = Modules;
+    }
   }
-  if (BlockLengths != NULL) {
-    FreePool(BlockLengths);
+
+  if (BestVersion == RMQR_TABLES_VERSION_COUNT) {
+    return EFI_BAD_BUFFER_SIZE;
   }
-  if (Blocks != NULL) {
-    FreePool(Blocks);
+
+  GetRmqrSegmentHeaderBits(BestVersion, HeaderBits);
+  UINTN Bits = ComputeOptimalSegmentsForHeaders(Payload, PayloadLength, HeaderBits, Trace, Segments, SegmentCount);
+
+  if ((EccLevel == ComputerInfoQrEccAutoBoost) &&
+      (Bits <= (UINTN)mRmqrDataCodewordCapacity[1][BestVersion] * 8)) {
+    SearchLevel = 1;
   }
 
-  return Status;
+  *Version = BestVersion;
+  *Level   = SearchLevel;
+  return EFI_SUCCESS;
 }
 
+//
+// Structured Append header: mode 0011, the symbol's position and the symbol
+// count minus one in four bits each, then the XOR of every payload byte.
+//
+typedef struct {
+  UINT8 Index;
+  UINT8 Count;
+  UINT8 Parity;
+} QR_STRUCTURED_APPEND;
+
+#define QR_MODE_STRUCTURED_APPEND         3
+#define QR_STRUCTURED_APPEND_HEADER_BITS  20
+
+//
+// Cuts Payload into consecutive chunks for Structured Append, making each
+// chunk as long as its optimal segmentation plus the Structured Append header
+// fits in BudgetBits at Version. Optimal cost never drops when a chunk grows
+// at either end, so taking the longest chunk every time uses the fewest
+// chunks any split could. Returns the chunk count, or a count above
+// COMPUTER_INFO_QR_MAX_STRUCTURED_APPEND_SYMBOLS once the payload does not fit.
+//
 STATIC
-VOID
-DrawFinderPattern(
-  IN OUT QR_MODULE_MATRIX      Modules,
-  IN OUT QR_FUNCTION_MATRIX    FunctionModules,
-  IN     INTN    X,
-  IN     INTN    Y,
-  IN     UINTN   Size
+UINTN
+SplitStructuredAppendPayload(
+  IN  CONST UINT8 *Payload,
+  IN  UINTN        PayloadLength,
+  IN  UINTN        Version,
+  IN  UINTN        BudgetBits,
+  OUT UINTN       *ChunkEnds OPTIONAL
   )
 {
-  for (INTN Dy = 0; Dy < 7; Dy++) {
-    for (INTN Dx = 0; Dx < 7; Dx++) {
-      INTN PosX = X + Dx;
-      INTN PosY = Y + Dy;
-      if (PosX < 0 || PosY < 0 || PosX >= (INTN)Size || PosY >= (INTN)Size) {
-        continue;
-      }
+  UINT32 HeaderBits[3];
+  UINTN  Count = 0;
+  UINTN  Start = 0;
 
-      BOOLEAN Outer = (Dx == 0 || Dx == 6 || Dy == 0 || Dy == 6);
-      BOOLEAN Inner = (Dx >= 2 && Dx <= 4 && Dy >= 2 && Dy <= 4);
-      UINT8 Value = (Outer || Inner) ? 1 : 0;
-      Modules[PosY][PosX] = (INT8)Value;
-      FunctionModules[PosY][PosX] = TRUE;
+  GetSegmentHeaderBits(Version, HeaderBits);
+
+  while (Start < PayloadLength) {
+    if (Count == COMPUTER_INFO_QR_MAX_STRUCTURED_APPEND_SYMBOLS) {
+      return Count + 1;
     }
-  }
 
-  for (INTN Dy = -1; Dy <= 7; Dy++) {
-    for (INTN Dx = -1; Dx <= 7; Dx++) {
-      INTN PosX = X + Dx;
-      INTN PosY = Y + Dy;
-      if (PosX < 0 || PosY < 0 || PosX >= (INTN)Size || PosY >= (INTN)Size) {
-        continue;
+    UINT32 Cost[QR_STATE_COUNT];
+    for (UINTN State = 0; State < QR_STATE_COUNT; State++) {
+      Cost[State] = QR_COST_INFINITE;
+    }
+
+    UINTN End = Start;
+    while ((End < PayloadLength) && ((End - Start) < COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH)) {
+      UINT32 Next[QR_STATE_COUNT];
+      UINT8  From[QR_STATE_COUNT];
+
+      AdvanceSegmentStates(Cost, Next, From, Payload[End], HeaderBits, (BOOLEAN)(End == Start));
+
+      UINT32 Bits = QR_COST_INFINITE;
+      for (UINTN State = 0; State < QR_STATE_COUNT; State++) {
+        Bits = MIN(Bits, Next[State]);
       }
 
-      if (PosX >= X && PosX < X + 7 && PosY >= Y && PosY < Y + 7) {
-        continue;
+      if (QR_STRUCTURED_APPEND_HEADER_BITS + (UINTN)Bits > BudgetBits) {
+        break;
       }
 
-      Modules[PosY][PosX] = 0;
-      FunctionModules[PosY][PosX] = TRUE;
+      CopyMem(Cost, Next, sizeof(Cost));
+      End++;
     }
+
+    if (End == Start) {
+      return COMPUTER_INFO_QR_MAX_STRUCTURED_APPEND_SYMBOLS + 1;
+    }
+
+    if (ChunkEnds != NULL) {
+      ChunkEnds[Count] = End;
+    }
+
+    Count++;
+    Start = End;
   }
+
+  return Count;
 }
 
+//
+// Plans a Structured Append sequence: the fewest symbols the payload fits
+// in, then the smallest version that still holds it in that many symbols,
+// then the smallest per-symbol bit budget that does. Splitting against that
+// budget instead of the version's full capacity balances the chunks, which
+// is what lets AutoBoost raise the level for every symbol alike.
+//
 STATIC
-VOID
-DrawAlignmentPattern(
-  IN OUT QR_MODULE_MATRIX      Modules,
-  IN OUT QR_FUNCTION_MATRIX    FunctionModules,
-  IN     INTN    CenterX,
-  IN     INTN    CenterY,
-  IN     UINTN   Size
+EFI_STATUS
+PlanStructuredAppend(
+  IN  CONST UINT8                *Payload,
+  IN  UINTN                       PayloadLength,
+  IN  COMPUTER_INFO_QR_ECC_LEVEL  EccLevel,
+  OUT UINTN                      *Version,
+  OUT UINTN                      *Level,
+  OUT UINTN                      *ChunkEnds,
+  OUT UINTN                      *SymbolCount
   )
 {
-  for (INTN Dy = -2; Dy <= 2; Dy++) {
-    for (INTN Dx = -2; Dx <= 2; Dx++) {
-      INTN PosX = CenterX + Dx;
-      INTN PosY = CenterY + Dy;
-      if (PosX < 0 || PosY < 0 || PosX >= (INTN)Size || PosY >= (INTN)Size) {
-        continue;
+  UINTN SearchLevel = (EccLevel == ComputerInfoQrEccAutoBoost) ? ComputerInfoQrEccLow : (UINTN)EccLevel;
+  if (SearchLevel >= QR_TABLES_LEVEL_COUNT) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Character count widths only change between version groups, and the
+  // last version of each group is the one needing the fewest symbols.
+  //
+  UINTN Symbols = COMPUTER_INFO_QR_MAX_STRUCTURED_APPEND_SYMBOLS + 1;
+  UINTN GroupEnd;
+  for (UINTN GroupStart = COMPUTER_INFO_QR_MIN_VERSION; GroupStart <= COMPUTER_INFO_QR_MAX_VERSION; GroupStart = GroupEnd + 1) {
+    GroupEnd = (GroupStart <= 9) ? 9 : ((GroupStart <= 26) ? 26 : COMPUTER_INFO_QR_MAX_VERSION);
+    UINTN Count = SplitStructuredAppendPayload(
+                    Payload,
+                    PayloadLength,
+                    GroupEnd,
+                    GetDataCodewordCapacity(GroupEnd, SearchLevel) * 8,
+                    NULL
+                    );
+    Symbols = MIN(Symbols, Count);
+  }
+
+  if (Symbols > COMPUTER_INFO_QR_MAX_STRUCTURED_APPEND_SYMBOLS) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  UINTN Selected = 0;
+  for (UINTN GroupStart = COMPUTER_INFO_QR_MIN_VERSION; (GroupStart <= COMPUTER_INFO_QR_MAX_VERSION) && (Selected == 0); GroupStart = GroupEnd + 1) {
+    GroupEnd = (GroupStart <= 9) ? 9 : ((GroupStart <= 26) ? 26 : COMPUTER_INFO_QR_MAX_VERSION);
+    if (SplitStructuredAppendPayload(Payload, PayloadLength, GroupEnd, GetDataCodewordCapacity(GroupEnd, SearchLevel) * 8, NULL) > Symbols) {
+      continue;
+    }
+
+    UINTN Low = GroupStart;
+    UINTN High = GroupEnd;
+    while (Low < High) {
+      UINTN Middle = Low + ((High - Low) / 2);
+      if (SplitStructuredAppendPayload(Payload, PayloadLength, Middle, GetDataCodewordCapacity(Middle, SearchLevel) * 8, NULL) <= Symbols) {
+        High = Middle;
+      } else {
+        Low = Middle + 1;
+      }
+    }
+
+    Selected = Low;
+  }
+
+  UINTN LowBits = QR_STRUCTURED_APPEND_HEADER_BITS + 1;
+  UINTN HighBits = GetDataCodewordCapacity(Selected, SearchLevel) * 8;
+  while (LowBits < HighBits) {
+    UINTN Middle = LowBits + ((HighBits - LowBits) / 2);
+    if (SplitStructuredAppendPayload(Payload, PayloadLength, Selected, Middle, NULL) <= Symbols) {
+      HighBits = Middle;
+    } else {
+      LowBits = Middle + 1;
+    }
+  }
+
+  if (EccLevel == ComputerInfoQrEccAutoBoost) {
+    while ((SearchLevel + 1 < QR_TABLES_LEVEL_COUNT) &&
+           (LowBits <= GetDataCodewordCapacity(Selected, SearchLevel + 1) * 8)) {
+      SearchLevel++;
+    }
+  }
+
+  *Version     = Selected;
+  *Level       = SearchLevel;
+  *SymbolCount = SplitStructuredAppendPayload(Payload, PayloadLength, Selected, LowBits, ChunkEnds);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+AppendSegment(
+  IN OUT QR_BIT_BUFFER    *Buffer,
+  IN     CONST UINT8      *Payload,
+  IN     CONST QR_SEGMENT *Segment,
+  IN     UINT32            ModeIndicator,
+  IN     UINTN             ModeIndicatorBits,
+  IN     UINTN             CharCountBits
+  )
+{
+  EFI_STATUS  Status;
+  CONST UINT8 *Data = &Payload[Segment->Offset];
+  UINTN       Length = Segment->Length;
+
+  if (Length >= (1ULL << CharCountBits)) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  Status = BitBufferAppendBits(Buffer, ModeIndicator, ModeIndicatorBits);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  Status = BitBufferAppendBits(Buffer, (UINT32)Length, CharCountBits);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  switch (Segment->Mode) {
+    case QR_MODE_NUMERIC:
+      for (UINTN Index = 0; (Index < Length) && !EFI_ERROR(Status); Index += 3) {
+        UINTN  Digits = ((Length - Index) < 3) ? (Length - Index) : 3;
+        UINT32 Value = 0;
+        for (UINTN Digit = 0; Digit < Digits; Digit++) {
+          Value = (Value * 10) + (UINT32)(Data[Index + Digit] - '0');
+        }
+
+        Status = BitBufferAppendBits(Buffer, Value, (Digits * 3) + 1);
+      }
+      break;
+
+    case QR_MODE_ALPHANUMERIC:
+      for (UINTN Index = 0; (Index < Length) && !EFI_ERROR(Status); Index += 2) {
+        if (Index + 1 < Length) {
+          UINT32 Value = (UINT32)((GetAlphanumericValue(Data[Index]) * 45) + GetAlphanumericValue(Data[Index + 1]));
+          Status = BitBufferAppendBits(Buffer, Value, 11);
+        } else {
+          Status = BitBufferAppendBits(Buffer, (UINT32)GetAlphanumericValue(Data[Index]), 6);
+        }
+      }
+      break;
+
+    default:
+      Status = BitBufferAppendBytes(Buffer, Data, Length);
+      break;
+  }
+
+  return Status;
+}
+
+//
+// Ends the data with up to TerminatorBits zero bits, as many as still fit,
+// then completes the last byte with zeros and fills the rest with pad
+// codewords.
+//
+STATIC
+EFI_STATUS
+TerminateDataCodewords(
+  IN OUT QR_BIT_BUFFER *Buffer,
+  IN     UINTN          DataBitCapacity,
+  IN     UINTN          TerminatorBits
+  )
+{
+  EFI_STATUS Status;
+  UINTN      RemainingBits = DataBitCapacity - BitBufferLength(Buffer);
+
+  Status = BitBufferAppendBits(Buffer, 0, MIN(RemainingBits, TerminatorBits));
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  if (Buffer->PendingBits != 0) {
+    Status = BitBufferAppendBits(Buffer, 0, 8 - Buffer->PendingBits);
+    if (EFI_ERROR(Status)) {
+      return Status;
+    }
+  }
+
+  BitBufferAppendPadding(Buffer);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+BuildDataCodewords(
+  IN  CONST UINT8                *Payload,
+  IN  CONST QR_SEGMENT           *Segments,
+  IN  UINTN                       SegmentCount,
+  IN  CONST QR_STRUCTURED_APPEND *StructuredAppend OPTIONAL,
+  IN  UINTN                       Version,
+  OUT UINT8                      *Codewords,
+  IN  UINTN                       DataCapacity
+  )
+{
+  if ((DataCapacity == 0) || (DataCapacity > COMPUTER_INFO_QR_MAX_DATA_CODEWORDS)) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  QR_BIT_BUFFER Buffer;
+  BitBufferInit(&Buffer, Codewords, DataCapacity);
+
+  UINTN DataBitCapacity = DataCapacity * 8;
+
+  EFI_STATUS Status;
+
+  if (StructuredAppend != NULL) {
+    UINT32 Header = ((UINT32)QR_MODE_STRUCTURED_APPEND << 16) |
+                    ((UINT32)(StructuredAppend->Index & 0xF) << 12) |
+                    ((UINT32)((StructuredAppend->Count - 1) & 0xF) << 8) |
+                    StructuredAppend->Parity;
+    Status = BitBufferAppendBits(&Buffer, Header, QR_STRUCTURED_APPEND_HEADER_BITS);
+    if (EFI_ERROR(Status)) {
+      return Status;
+    }
+  }
+
+  for (UINTN Index = 0; Index < SegmentCount; Index++) {
+    Status = AppendSegment(
+               &Buffer,
+               Payload,
+               &Segments[Index],
+               Segments[Index].Mode,
+               4,
+               GetCharCountBits(Segments[Index].Mode, Version)
+               );
+    if (EFI_ERROR(Status)) {
+      return Status;
+    }
+  }
+
+  return TerminateDataCodewords(&Buffer, DataBitCapacity, 4);
+}
+
+//
+// rMQR numbers its modes 001, 010 and 011 for numeric, alphanumeric and byte
+// and ends the data with a 3-bit terminator.
+//
+STATIC
+EFI_STATUS
+BuildRmqrDataCodewords(
+  IN  CONST UINT8      *Payload,
+  IN  CONST QR_SEGMENT *Segments,
+  IN  UINTN             SegmentCount,
+  IN  UINTN             Version,
+  OUT UINT8            *Codewords,
+  IN  UINTN             DataCapacity
+  )
+{
+  QR_BIT_BUFFER Buffer;
+  BitBufferInit(&Buffer, Codewords, DataCapacity);
+
+  for (UINTN Index = 0; Index < SegmentCount; Index++) {
+    UINTN Mode = (Segments[Index].Mode == QR_MODE_NUMERIC) ? 0 : ((Segments[Index].Mode == QR_MODE_ALPHANUMERIC) ? 1 : 2);
+
+    EFI_STATUS Status = AppendSegment(
+                          &Buffer,
+                          Payload,
+                          &Segments[Index],
+                          (UINT32)(Mode + 1),
+                          RMQR_MODE_INDICATOR_BITS,
+                          mRmqrVersions[Version].CharCountBits[Mode]
+                          );
+    if (EFI_ERROR(Status)) {
+      return Status;
+    }
+  }
+
+  return TerminateDataCodewords(&Buffer, DataCapacity * 8, RMQR_MODE_INDICATOR_BITS);
+}
+
+STATIC
+CONST QR_GENERATOR_POLYNOMIAL *
+GetGeneratorPolynomial(
+  IN UINTN Degree
+  )
+{
+  if ((Degree >= ARRAY_SIZE(mGeneratorIndexByDegree)) || (mGeneratorIndexByDegree[Degree] == 0xFF)) {
+    return NULL;
+  }
+
+  return &mGeneratorPolynomials[mGeneratorIndexByDegree[Degree]];
+}
+
+//
+// Reed-Solomon parity is produced by an LFSR whose register is held as
+// little-endian 64-bit words, so advancing it by one codeword is a word-wide
+// shift. A QR_RS_PRODUCT_TABLE caches Factor * g[I] for the generator used
+// last, laid out the same way, which turns each data byte into a single row
+// XOR. Every encoder arena has its own table, so contexts on different
+// threads never share one.
+//
+#define QR_RS_REGISTER_WORDS  4
+
+#if COMPUTER_INFO_QR_MAX_ECC_CODEWORDS_PER_BLOCK > QR_RS_REGISTER_WORDS * 8
+#error "Reed-Solomon register is too narrow for COMPUTER_INFO_QR_MAX_ECC_CODEWORDS_PER_BLOCK."
+#endif
+
+typedef struct {
+  CONST QR_GENERATOR_POLYNOMIAL *Generator;
+  UINT64                        Rows[256][QR_RS_REGISTER_WORDS];
+} QR_RS_PRODUCT_TABLE;
+
+STATIC
+VOID
+LoadReedSolomonProductRows(
+  IN OUT QR_RS_PRODUCT_TABLE           *Products,
+  IN     CONST QR_GENERATOR_POLYNOMIAL *Generator
+  )
+{
+  if (Products->Generator == Generator) {
+    return;
+  }
+
+  ZeroMem(Products->Rows, sizeof(Products->Rows));
+  for (UINTN Factor = 1; Factor < 256; Factor++) {
+    UINTN FactorLog = mGaloisLogTable[Factor];
+    for (UINTN Index = 0; Index < Generator->Degree; Index++) {
+      UINT64 Product = mGaloisExpTable[Generator->Coefficients[Index] + FactorLog];
+      Products->Rows[Factor][Index / 8] |= Product << ((Index % 8) * 8);
+    }
+  }
+
+  Products->Generator = Generator;
+}
+
+//
+// Parity byte I is stored at Parity[I * ParityStride], which lets callers
+// write a block's ECC codewords straight into their interleaved positions.
+//
+STATIC
+VOID
+ComputeReedSolomon(
+  IN  CONST UINT8                   *Data,
+  IN  UINTN                          DataCount,
+  OUT UINT8                         *Parity,
+  IN  UINTN                          ParityStride,
+  IN  CONST QR_GENERATOR_POLYNOMIAL *Generator,
+  IN  QR_RS_PRODUCT_TABLE           *Products
+  )
+{
+  UINT64 Register0 = 0;
+  UINT64 Register1 = 0;
+  UINT64 Register2 = 0;
+  UINT64 Register3 = 0;
+
+  LoadReedSolomonProductRows(Products, Generator);
+
+  //
+  // The register words are kept in locals rather than an array so they stay
+  // in general purpose registers across the whole block.
+  //
+  for (UINTN Index = 0; Index < DataCount; Index++) {
+    CONST UINT64 *Row = Products->Rows[(UINT8)(Data[Index] ^ (UINT8)Register0)];
+
+    Register0 = ((Register0 >> 8) | (Register1 << 56)) ^ Row[0];
+    Register1 = ((Register1 >> 8) | (Register2 << 56)) ^ Row[1];
+    Register2 = ((Register2 >> 8) | (Register3 << 56)) ^ Row[2];
+    Register3 = (Register3 >> 8) ^ Row[3];
+  }
+
+  for (UINTN Index = 0; Index < Generator->Degree; Index++) {
+    UINT64 Word = (Index < 8) ? Register0 : (Index < 16) ? Register1 : (Index < 24) ? Register2 : Register3;
+    Parity[Index * ParityStride] = (UINT8)(Word >> ((Index % 8) * 8));
+  }
+}
+
+//
+// Produces the final interleaved codeword sequence directly: every data
+// codeword is scattered to its interleaved index and each block's parity is
+// written with a stride of NumBlocks into the ECC section. Short blocks come
+// first and lack the last data column, which only long blocks fill.
+//
+STATIC
+EFI_STATUS
+BuildCodewordSequence(
+  IN  CONST UINT8         *DataCodewords,
+  IN  UINTN                DataCodewordCount,
+  IN  UINTN                TotalCodewords,
+  IN  UINTN                NumBlocks,
+  IN  UINTN                EccCodewordsPerBlock,
+  IN  QR_RS_PRODUCT_TABLE *Products,
+  OUT UINT8               *Codewords
+  )
+{
+  if ((DataCodewords == NULL) || (Codewords == NULL) || (Products == NULL) ||
+      (NumBlocks == 0) || (EccCodewordsPerBlock == 0) ||
+      (NumBlocks > COMPUTER_INFO_QR_MAX_ERROR_CORRECTION_BLOCKS) ||
+      (EccCodewordsPerBlock > COMPUTER_INFO_QR_MAX_ECC_CODEWORDS_PER_BLOCK) ||
+      (TotalCodewords > COMPUTER_INFO_QR_MAX_TOTAL_CODEWORDS) ||
+      (DataCodewordCount > COMPUTER_INFO_QR_MAX_DATA_CODEWORDS)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  UINTN RawCodewords = TotalCodewords;
+  UINTN NumLongBlocks = RawCodewords % NumBlocks;
+  UINTN NumShortBlocks = NumBlocks - NumLongBlocks;
+  UINTN ShortBlockTotalLength = RawCodewords / NumBlocks;
+
+  if (ShortBlockTotalLength < EccCodewordsPerBlock) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  CONST QR_GENERATOR_POLYNOMIAL *Generator = GetGeneratorPolynomial(EccCodewordsPerBlock);
+  if (Generator == NULL) {
+    return EFI_UNSUPPORTED;
+  }
+
+  UINTN ShortBlockDataLength = ShortBlockTotalLength - EccCodewordsPerBlock;
+
+  UINTN ExpectedDataCodewords = (ShortBlockDataLength * NumBlocks) + NumLongBlocks;
+  if (ExpectedDataCodewords != DataCodewordCount) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  CONST UINT8 *Block = DataCodewords;
+  for (UINTN BlockIndex = 0; BlockIndex < NumBlocks; BlockIndex++) {
+    QR_STAGE_BEGIN(Interleave);
+    UINT8 *Output = &Codewords[BlockIndex];
+
+    for (UINTN Index = 0; Index < ShortBlockDataLength; Index++) {
+      Output[Index * NumBlocks] = Block[Index];
+    }
+
+    UINTN DataLength = ShortBlockDataLength;
+    if (BlockIndex >= NumShortBlocks) {
+      Codewords[(ShortBlockDataLength * NumBlocks) + (BlockIndex - NumShortBlocks)] = Block[DataLength];
+      DataLength++;
+    }
+
+    QR_STAGE_END(Interleave);
+
+    QR_STAGE_BEGIN(ReedSolomon);
+    ComputeReedSolomon(
+      Block,
+      DataLength,
+      &Codewords[DataCodewordCount + BlockIndex],
+      NumBlocks,
+      Generator,
+      Products
+      );
+    QR_STAGE_END(ReedSolomon);
+
+    Block += DataLength;
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+VOID
+DrawFinderPattern(
+  IN OUT UINT64 Modules[][QR_ROW_WORDS],
+  IN OUT UINT64 FunctionModules[][QR_ROW_WORDS],
+  IN     INTN   X,
+  IN     INTN   Y,
+  IN     UINTN  Size
+  )
+{
+  for (INTN Dy = 0; Dy < 7; Dy++) {
+    for (INTN Dx = 0; Dx < 7; Dx++) {
+      INTN PosX = X + Dx;
+      INTN PosY = Y + Dy;
+      if (PosX < 0 || PosY < 0 || PosX >= (INTN)Size || PosY >= (INTN)Size) {
+        continue;
+      }
+
+      BOOLEAN Outer = (Dx == 0 || Dx == 6 || Dy == 0 || Dy == 6);
+      BOOLEAN Inner = (Dx >= 2 && Dx <= 4 && Dy >= 2 && Dy <= 4);
+      QrSetFunctionModule(Modules, FunctionModules, (UINTN)PosX, (UINTN)PosY, (BOOLEAN)(Outer || Inner));
+    }
+  }
+
+  for (INTN Dy = -1; Dy <= 7; Dy++) {
+    for (INTN Dx = -1; Dx <= 7; Dx++) {
+      INTN PosX = X + Dx;
+      INTN PosY = Y + Dy;
+      if (PosX < 0 || PosY < 0 || PosX >= (INTN)Size || PosY >= (INTN)Size) {
+        continue;
+      }
+
+      if (PosX >= X && PosX < X + 7 && PosY >= Y && PosY < Y + 7) {
+        continue;
+      }
+
+      QrSetFunctionModule(Modules, FunctionModules, (UINTN)PosX, (UINTN)PosY, FALSE);
+    }
+  }
+}
+
+STATIC
+VOID
+DrawAlignmentPattern(
+  IN OUT UINT64 Modules[][QR_ROW_WORDS],
+  IN OUT UINT64 FunctionModules[][QR_ROW_WORDS],
+  IN     INTN   CenterX,
+  IN     INTN   CenterY,
+  IN     UINTN  Size
+  )
+{
+  for (INTN Dy = -2; Dy <= 2; Dy++) {
+    for (INTN Dx = -2; Dx <= 2; Dx++) {
+      INTN PosX = CenterX + Dx;
+      INTN PosY = CenterY + Dy;
+      if (PosX < 0 || PosY < 0 || PosX >= (INTN)Size || PosY >= (INTN)Size) {
+        continue;
       }
 
       INTN AbsDx = (Dx >= 0) ? Dx : -Dx;
       INTN AbsDy = (Dy >= 0) ? Dy : -Dy;
       INTN Distance = (AbsDx > AbsDy) ? AbsDx : AbsDy;
-      UINT8 Value = (UINT8)((Distance != 1) ? 1 : 0);
-      Modules[PosY][PosX] = (INT8)Value;
-      FunctionModules[PosY][PosX] = TRUE;
+      QrSetFunctionModule(Modules, FunctionModules, (UINTN)PosX, (UINTN)PosY, (BOOLEAN)(Distance != 1));
+    }
+  }
+}
+
+STATIC
+VOID
+DrawAlignmentPatterns(
+  IN OUT UINT64       Modules[][QR_ROW_WORDS],
+  IN OUT UINT64       FunctionModules[][QR_ROW_WORDS],
+  IN     CONST UINT8  *Centers,
+  IN     UINTN        CenterCount,
+  IN     UINTN        Size
+  )
+{
+  if ((Centers == NULL) || (CenterCount == 0)) {
+    return;
+  }
+
+  UINT8 LastCenter = Centers[CenterCount - 1];
+
+  for (UINTN YIndex = 0; YIndex < CenterCount; YIndex++) {
+    for (UINTN XIndex = 0; XIndex < CenterCount; XIndex++) {
+      UINT8 CenterX = Centers[XIndex];
+      UINT8 CenterY = Centers[YIndex];
+
+      if (((CenterX == 6) && (CenterY == 6)) ||
+          ((CenterX == 6) && (CenterY == LastCenter)) ||
+          ((CenterX == LastCenter) && (CenterY == 6))) {
+        continue;
+      }
+
+      DrawAlignmentPattern(Modules, FunctionModules, CenterX, CenterY, Size);
+    }
+  }
+}
+
+STATIC
+VOID
+DrawTimingPatterns(
+  IN OUT UINT64 Modules[][QR_ROW_WORDS],
+  IN OUT UINT64 FunctionModules[][QR_ROW_WORDS],
+  IN     UINTN  Size
+  )
+{
+  for (INTN Index = 0; Index < (INTN)Size; Index++) {
+    if (!QrMatrixGet(FunctionModules, (UINTN)Index, 6)) {
+      QrSetFunctionModule(Modules, FunctionModules, (UINTN)Index, 6, (BOOLEAN)((Index % 2) == 0));
+    }
+    if (!QrMatrixGet(FunctionModules, 6, (UINTN)Index)) {
+      QrSetFunctionModule(Modules, FunctionModules, 6, (UINTN)Index, (BOOLEAN)((Index % 2) == 0));
+    }
+  }
+}
+
+STATIC
+VOID
+ReserveFormatInfo(
+  IN OUT UINT64 FunctionModules[][QR_ROW_WORDS],
+  IN     UINTN  Size
+  )
+{
+  for (INTN Index = 0; Index <= 8; Index++) {
+    if (Index != 6) {
+      QrMatrixSet(FunctionModules, (UINTN)Index, 8, TRUE);
+      QrMatrixSet(FunctionModules, 8, (UINTN)Index, TRUE);
+    }
+  }
+
+  for (INTN Index = 0; Index < 7; Index++) {
+    QrMatrixSet(FunctionModules, Size - 1 - (UINTN)Index, 8, TRUE);
+    QrMatrixSet(FunctionModules, 8, Size - 1 - (UINTN)Index, TRUE);
+  }
+
+  QrMatrixSet(FunctionModules, Size - 8, 8, TRUE);
+  QrMatrixSet(FunctionModules, 8, Size - 8, TRUE);
+}
+
+STATIC
+UINT8
+MaskBit(
+  IN UINTN Mask,
+  IN INTN  X,
+  IN INTN  Y
+  )
+{
+  switch (Mask) {
+  case 0:
+    return (UINT8)(((X + Y) & 0x1) == 0);
+  case 1:
+    return (UINT8)((Y & 0x1) == 0);
+  case 2:
+    return (UINT8)((X % 3) == 0);
+  case 3:
+    return (UINT8)(((X + Y) % 3) == 0);
+  case 4:
+    return (UINT8)((((Y / 2) + (X / 3)) & 0x1) == 0);
+  case 5:
+    return (UINT8)((((X * Y) % 2) + ((X * Y) % 3)) == 0);
+  case 6:
+    return (UINT8)(((((X * Y) % 2) + ((X * Y) % 3)) & 0x1) == 0);
+  case 7:
+    return (UINT8)(((((X + Y) % 2) + ((X * Y) % 3)) & 0x1) == 0);
+  default:
+    return 0;
+  }
+}
+
+//
+// Every mask is precomputed per version as a plane of the modules it flips,
+// already cleared on function modules, so applying a mask is a XOR of packed
+// words. Matrix rows are contiguous, and the plane is zero past the last
+// column, so a whole matrix is XORed as one run of Size * QR_ROW_WORDS words.
+//
+typedef
+VOID
+(*QR_XOR_WORDS)(
+  OUT UINT64       *Destination,
+  IN  CONST UINT64 *Source,
+  IN  CONST UINT64 *Plane,
+  IN  UINTN         WordCount
+  );
+
+STATIC
+VOID
+XorWordsPortable(
+  OUT UINT64       *Destination,
+  IN  CONST UINT64 *Source,
+  IN  CONST UINT64 *Plane,
+  IN  UINTN         WordCount
+  )
+{
+  for (UINTN Index = 0; Index < WordCount; Index++) {
+    Destination[Index] = Source[Index] ^ Plane[Index];
+  }
+}
+
+#if defined (MDE_CPU_X64) && defined (__GNUC__)
+
+//
+// GCC and Clang vector extensions compile to SSE2 or AVX2 XORs without
+// intrinsic headers; the target attributes enable the instructions for these
+// functions only. The types carry word alignment, so loads and stores are
+// unaligned moves.
+//
+typedef UINT64 QR_VECTOR128 __attribute__ ((vector_size (16), aligned (8), may_alias));
+typedef UINT64 QR_VECTOR256 __attribute__ ((vector_size (32), aligned (8), may_alias));
+
+STATIC
+VOID
+__attribute__ ((target ("sse2")))
+XorWordsSse2(
+  OUT UINT64       *Destination,
+  IN  CONST UINT64 *Source,
+  IN  CONST UINT64 *Plane,
+  IN  UINTN         WordCount
+  )
+{
+  UINTN Index = 0;
+
+  for ( ; Index + 2 <= WordCount; Index += 2) {
+    *(QR_VECTOR128 *)&Destination[Index] = *(CONST QR_VECTOR128 *)&Source[Index] ^ *(CONST QR_VECTOR128 *)&Plane[Index];
+  }
+
+  XorWordsPortable(&Destination[Index], &Source[Index], &Plane[Index], WordCount - Index);
+}
+
+STATIC
+VOID
+__attribute__ ((target ("avx2")))
+XorWordsAvx2(
+  OUT UINT64       *Destination,
+  IN  CONST UINT64 *Source,
+  IN  CONST UINT64 *Plane,
+  IN  UINTN         WordCount
+  )
+{
+  UINTN Index = 0;
+
+  for ( ; Index + 4 <= WordCount; Index += 4) {
+    *(QR_VECTOR256 *)&Destination[Index] = *(CONST QR_VECTOR256 *)&Source[Index] ^ *(CONST QR_VECTOR256 *)&Plane[Index];
+  }
+
+  XorWordsSse2(&Destination[Index], &Source[Index], &Plane[Index], WordCount - Index);
+}
+
+//
+// AVX2 needs the CPU feature and firmware that enabled the AVX register
+// state in XCR0, which not every firmware does during boot services. SSE2 is
+// part of X64 and enabled by the UEFI calling convention.
+//
+STATIC
+BOOLEAN
+QrCpuSupportsAvx2(
+  VOID
+  )
+{
+  UINT32 MaxLeaf;
+  UINT32 Ebx;
+  UINT32 Ecx;
+
+  AsmCpuid(0, &MaxLeaf, NULL, NULL, NULL);
+  if (MaxLeaf < 7) {
+    return FALSE;
+  }
+
+  AsmCpuid(1, NULL, NULL, &Ecx, NULL);
+  if ((Ecx & (BIT27 | BIT28)) != (BIT27 | BIT28)) {
+    return FALSE;
+  }
+
+  if ((AsmXGetBv(0) & (BIT1 | BIT2)) != (BIT1 | BIT2)) {
+    return FALSE;
+  }
+
+  AsmCpuidEx(7, 0, NULL, &Ebx, NULL, NULL);
+  return (BOOLEAN)((Ebx & BIT5) != 0);
+}
+
+#endif
+
+//
+// Picked by SelectXorWords, which only runs on the CPU that calls into the
+// encoder. Mask workers may run on APs and never probe CPU features
+// themselves; until a routine is picked they use the baseline one.
+//
+STATIC QR_XOR_WORDS mXorWords = NULL;
+
+STATIC
+QR_XOR_WORDS
+GetXorWords(
+  VOID
+  )
+{
+  if (mXorWords == NULL) {
+#if defined (MDE_CPU_X64) && defined (__GNUC__)
+    return XorWordsSse2;
+#else
+    return XorWordsPortable;
+#endif
+  }
+
+  return mXorWords;
+}
+
+STATIC
+VOID
+BuildMaskPlane(
+  IN  CONST UINT64 FunctionModules[][QR_ROW_WORDS],
+  IN  UINTN        Mask,
+  IN  UINTN        Width,
+  IN  UINTN        Height,
+  OUT UINT64       MaskPlane[][QR_ROW_WORDS]
+  )
+{
+  UINTN RowWords = QrRowWords(Width);
+
+  for (INTN Y = 0; Y < (INTN)Height; Y++) {
+    for (INTN X = 0; X < (INTN)Width; X++) {
+      if (MaskBit(Mask, X, Y)) {
+        MaskPlane[Y][X / 64] |= (UINT64)1 << (X % 64);
+      }
+    }
+
+    for (UINTN Word = 0; Word < RowWords; Word++) {
+      MaskPlane[Y][Word] &= ~FunctionModules[Y][Word];
+    }
+  }
+}
+
+//
+// Builds the eight mask planes back to back, Size rows each.
+//
+STATIC
+VOID
+BuildMaskPlanes(
+  IN  CONST UINT64 FunctionModules[][QR_ROW_WORDS],
+  IN  UINTN        Size,
+  OUT UINT64       MaskPlanes[][QR_ROW_WORDS]
+  )
+{
+  for (UINTN Mask = 0; Mask < QR_MASK_COUNT; Mask++) {
+    BuildMaskPlane(FunctionModules, Mask, Size, Size, &MaskPlanes[Mask * Size]);
+  }
+}
+
+//
+// Writes Modules XOR MaskPlane to Candidate over the first Rows rows.
+//
+STATIC
+VOID
+ApplyMask(
+  OUT UINT64       Candidate[][QR_ROW_WORDS],
+  IN  CONST UINT64 Modules[][QR_ROW_WORDS],
+  IN  CONST UINT64 MaskPlane[][QR_ROW_WORDS],
+  IN  UINTN        Rows
+  )
+{
+  GetXorWords()(&Candidate[0][0], &Modules[0][0], &MaskPlane[0][0], Rows * QR_ROW_WORDS);
+}
+
+//
+// Format information encodes the level as L = 01, M = 00, Q = 11, H = 10.
+//
+STATIC CONST UINT8 mFormatLevelBits[QR_TABLES_LEVEL_COUNT] = { 0x01, 0x00, 0x03, 0x02 };
+
+STATIC
+UINT16
+CalculateFormatBits(
+  IN UINTN Level,
+  IN UINTN Mask
+  )
+{
+  UINT16 Format = 0;
+  UINT16 Data = (UINT16)((mFormatLevelBits[Level & 0x3] << 3) | (Mask & 0x7));
+  Format = (UINT16)(Data << 10);
+
+  UINT16 Polynomial = 0x537;
+  for (INTN Bit = 14; Bit >= 10; Bit--) {
+    if ((Format >> Bit) & 0x1) {
+      Format ^= (UINT16)(Polynomial << (Bit - 10));
+    }
+  }
+
+  Format = (UINT16)((Data << 10) | Format);
+  Format ^= 0x5412;
+  return Format;
+}
+
+STATIC
+VOID
+DrawFormatBits(
+  IN OUT QR_MODULE_MATRIX      Modules,
+  IN     UINTN                 Level,
+  IN     UINTN                 Mask,
+  IN     UINTN                 Size
+  )
+{
+  UINT16 Format = CalculateFormatBits(Level, Mask);
+
+  CONST INTN HorizontalPositions[8] = { 0, 1, 2, 3, 4, 5, 7, 8 };
+  CONST INTN VerticalPositions[8]   = { 0, 1, 2, 3, 4, 5, 7, 8 };
+
+  for (INTN Index = 0; Index < 8; Index++) {
+    BOOLEAN Bit = (BOOLEAN)((Format >> Index) & 0x1);
+    INTN    Row = VerticalPositions[Index];
+    QrMatrixSet(Modules, 8, (UINTN)Row, Bit);
+  }
+
+  for (INTN Index = 0; Index < 8; Index++) {
+    BOOLEAN Bit    = (BOOLEAN)((Format >> (14 - Index)) & 0x1);
+    INTN    Column = HorizontalPositions[Index];
+    QrMatrixSet(Modules, (UINTN)Column, 8, Bit);
+  }
+
+  for (INTN Index = 0; Index < 8; Index++) {
+    BOOLEAN Bit    = (BOOLEAN)((Format >> Index) & 0x1);
+    INTN    Column = (INTN)Size - 1 - Index;
+    QrMatrixSet(Modules, (UINTN)Column, 8, Bit);
+  }
+
+  for (INTN Index = 0; Index < 8; Index++) {
+    BOOLEAN Bit = (BOOLEAN)((Format >> (14 - Index)) & 0x1);
+    INTN    Row = (INTN)Size - 1 - Index;
+    QrMatrixSet(Modules, 8, (UINTN)Row, Bit);
+  }
+
+  QrMatrixSet(Modules, 8, Size - 8, TRUE);
+}
+
+STATIC
+VOID
+DrawVersionInformation(
+  IN OUT UINT64 Modules[][QR_ROW_WORDS],
+  IN OUT UINT64 FunctionModules[][QR_ROW_WORDS],
+  IN     UINTN  Version,
+  IN     UINTN  Size
+  )
+{
+  if (Version < 7) {
+    return;
+  }
+
+  UINT32 VersionInfo = ComputeVersionInformation(Version);
+
+  for (UINTN Index = 0; Index < 6; Index++) {
+    BOOLEAN Bit0 = (BOOLEAN)((VersionInfo >> (Index * 3)) & 0x1);
+    BOOLEAN Bit1 = (BOOLEAN)((VersionInfo >> ((Index * 3) + 1)) & 0x1);
+    BOOLEAN Bit2 = (BOOLEAN)((VersionInfo >> ((Index * 3) + 2)) & 0x1);
+
+    UINTN BottomRow = Size - 11;
+    QrSetFunctionModule(Modules, FunctionModules, Index, BottomRow, Bit0);
+    QrSetFunctionModule(Modules, FunctionModules, Index, BottomRow + 1, Bit1);
+    QrSetFunctionModule(Modules, FunctionModules, Index, BottomRow + 2, Bit2);
+
+    UINTN RightColumn = Size - 11;
+    QrSetFunctionModule(Modules, FunctionModules, RightColumn, Index, Bit0);
+    QrSetFunctionModule(Modules, FunctionModules, RightColumn + 1, Index, Bit1);
+    QrSetFunctionModule(Modules, FunctionModules, RightColumn + 2, Index, Bit2);
+  }
+}
+
+//
+// Everything except the data modules, the mask and the format bits depends
+// only on the version, so each version's function patterns are drawn once
+// into a template: the base modules, the function module map, the eight
+// mask planes, and the data placement table listing the module of every
+// codeword bit in zig-zag order with function modules already skipped.
+// Remainder bits are not listed; their modules stay light. Templates are
+// built on first use or by PrecomputeComputerInfoQrTemplates and kept until
+// FreeComputerInfoQrCaches.
+//
+// The ten planes hold Size rows each and share one allocation with the
+// placement table, so a template takes 240 bytes per row plus 16 per
+// codeword: about 5 KB for version 1 and 100 KB for version 40.
+//
+typedef struct {
+  UINT8 Column;
+  UINT8 Row;
+} QR_PLACEMENT_ENTRY;
+
+typedef struct {
+  UINTN              Size;
+  UINT64             (*BaseModules)[QR_ROW_WORDS];
+  UINT64             (*FunctionModules)[QR_ROW_WORDS];
+  //
+  // Mask plane M starts at MaskPlanes[M * Size].
+  //
+  UINT64             (*MaskPlanes)[QR_ROW_WORDS];
+  QR_PLACEMENT_ENTRY *Placement;
+  UINT64             Rows[][QR_ROW_WORDS];
+} QR_VERSION_TEMPLATE;
+
+STATIC QR_VERSION_TEMPLATE *mVersionTemplates[COMPUTER_INFO_QR_MAX_VERSION - COMPUTER_INFO_QR_MIN_VERSION + 1];
+
+//
+// Codewords run in a zig-zag over column pairs, right to left starting with
+// the pair whose right column is FirstColumn, alternately up and down. QR
+// starts at its last column and steps over its vertical timing pattern in
+// column 6; rMQR's last column is all function modules, so it starts one
+// column in and its pairs never meet column 6.
+//
+STATIC
+VOID
+BuildPlacementTable(
+  IN  CONST UINT64        FunctionModules[][QR_ROW_WORDS],
+  IN  UINTN               Height,
+  IN  UINTN               FirstColumn,
+  OUT QR_PLACEMENT_ENTRY *Entries,
+  IN  UINTN               EntryCount
+  )
+{
+  UINTN   EntryIndex = 0;
+  BOOLEAN GoingUp = TRUE;
+
+  for (INTN Column = (INTN)FirstColumn; Column > 0; Column -= 2) {
+    if (Column == 6) {
+      Column--;
+    }
+
+    for (UINTN Offset = 0; Offset < Height; Offset++) {
+      UINTN Row = GoingUp ? (Height - 1 - Offset) : Offset;
+
+      for (UINTN ColumnOffset = 0; ColumnOffset < 2; ColumnOffset++) {
+        UINTN CurrentColumn = (UINTN)Column - ColumnOffset;
+        if (QrMatrixGet(FunctionModules, CurrentColumn, Row)) {
+          continue;
+        }
+
+        if (EntryIndex < EntryCount) {
+          Entries[EntryIndex].Column = (UINT8)CurrentColumn;
+          Entries[EntryIndex].Row = (UINT8)Row;
+        }
+        EntryIndex++;
+      }
+    }
+
+    GoingUp = !GoingUp;
+  }
+}
+
+STATIC
+CONST QR_VERSION_TEMPLATE *
+GetVersionTemplate(
+  IN UINTN Version
+  )
+{
+  UINTN Slot = Version - COMPUTER_INFO_QR_MIN_VERSION;
+
+  if (mVersionTemplates[Slot] != NULL) {
+    return mVersionTemplates[Slot];
+  }
+
+  UINTN Size       = 4 * Version + 17;
+  UINTN EntryCount = GetTotalCodewords(Version) * 8;
+  QR_VERSION_TEMPLATE *Template = AllocateZeroPool(
+                                    sizeof(*Template) +
+                                    ((2 + QR_MASK_COUNT) * Size * sizeof(Template->Rows[0])) +
+                                    (EntryCount * sizeof(QR_PLACEMENT_ENTRY))
+                                    );
+  if (Template == NULL) {
+    return NULL;
+  }
+
+  Template->Size            = Size;
+  Template->BaseModules     = &Template->Rows[0];
+  Template->FunctionModules = &Template->Rows[Size];
+  Template->MaskPlanes      = &Template->Rows[2 * Size];
+  Template->Placement       = (QR_PLACEMENT_ENTRY *)&Template->Rows[(2 + QR_MASK_COUNT) * Size];
+
+  UINT8 AlignmentCenters[QR_MAX_ALIGNMENT_PATTERN_COUNT];
+  UINTN AlignmentCount;
+  GetAlignmentPatternCenters(Version, AlignmentCenters, &AlignmentCount);
+
+  DrawFinderPattern(Template->BaseModules, Template->FunctionModules, 0, 0, Size);
+  DrawFinderPattern(Template->BaseModules, Template->FunctionModules, (INTN)Size - 7, 0, Size);
+  DrawFinderPattern(Template->BaseModules, Template->FunctionModules, 0, (INTN)Size - 7, Size);
+
+  DrawTimingPatterns(Template->BaseModules, Template->FunctionModules, Size);
+
+  DrawAlignmentPatterns(Template->BaseModules, Template->FunctionModules, AlignmentCenters, AlignmentCount, Size);
+
+  ReserveFormatInfo(Template->FunctionModules, Size);
+  DrawVersionInformation(Template->BaseModules, Template->FunctionModules, Version, Size);
+
+  QrSetFunctionModule(Template->BaseModules, Template->FunctionModules, 8, Size - 8, TRUE);
+
+  BuildMaskPlanes(Template->FunctionModules, Size, Template->MaskPlanes);
+  BuildPlacementTable(Template->FunctionModules, Size, Size - 1, Template->Placement, EntryCount);
+
+  //
+  // Encodes on other contexts may have built the same template meanwhile;
+  // the first one published wins.
+  //
+  if (InterlockedCompareExchangePointer((VOID **)&mVersionTemplates[Slot], NULL, Template) != NULL) {
+    FreePool(Template);
+  }
+
+  return mVersionTemplates[Slot];
+}
+
+STATIC
+VOID
+PlaceCodewords(
+  IN OUT QR_MODULE_MATRIX          Modules,
+  IN     CONST QR_PLACEMENT_ENTRY *Placement,
+  IN     CONST UINT8              *Codewords,
+  IN     UINTN                     CodewordCount
+  )
+{
+  for (UINTN Index = 0; Index < CodewordCount; Index++) {
+    UINTN Byte = Codewords[Index];
+    CONST QR_PLACEMENT_ENTRY *Entry = &Placement[Index * 8];
+
+    for (UINTN Bit = 0; Bit < 8; Bit++) {
+      UINT64 Value = (Byte >> (7 - Bit)) & 0x1;
+      Modules[Entry[Bit].Row][Entry[Bit].Column / 64] |= Value << (Entry[Bit].Column % 64);
     }
   }
 }
 
+//
+// rMQR function patterns: a finder pattern with its separator at the top
+// left, a 5x5 sub-finder at the bottom right, corner finder sub-patterns in
+// the other two corners, timing patterns along all four edges and down the
+// middle of every alignment pattern column, and 3x3 alignment patterns where
+// those columns meet the top and bottom edges. Format information sits next
+// to the finder and next to the sub-finder. rMQR has a single mask, QR's
+// mask 4, and no mask search.
+//
+typedef UINT64 QR_RMQR_MATRIX[COMPUTER_INFO_QR_RMQR_MAX_HEIGHT][QR_ROW_WORDS];
+
+#define RMQR_MASK                  4
+#define RMQR_FORMAT_BITS           18
+#define RMQR_FINDER_FORMAT_MASK    0x1FAB2
+#define RMQR_SUBFINDER_FORMAT_MASK 0x20A7B
+
+typedef struct {
+  UINTN              Width;
+  UINTN              Height;
+  QR_RMQR_MATRIX     BaseModules;
+  QR_RMQR_MATRIX     FunctionModules;
+  QR_RMQR_MATRIX     MaskPlane;
+  QR_PLACEMENT_ENTRY Placement[];
+} QR_RMQR_TEMPLATE;
+
+STATIC QR_RMQR_TEMPLATE *mRmqrTemplates[COMPUTER_INFO_QR_RMQR_VERSION_COUNT];
+
+//
+// Alignment pattern columns per symbol width, zero terminated.
+//
+STATIC CONST UINT8 mRmqrAlignmentColumns[][5] = {
+  { 27 },
+  { 43, 21 },
+  { 59, 19, 39 },
+  { 77, 25, 51 },
+  { 99, 23, 49, 75 },
+  { 139, 27, 55, 83, 111 }
+};
+
+//
+// Returns the module of format bit Bit, least significant first, in the copy
+// next to the finder or, with SubFinder, the copy next to the sub-finder.
+// Each copy is a 3x5 block plus three modules beside it.
+//
 STATIC
 VOID
-DrawAlignmentPatterns(
-  IN OUT QR_MODULE_MATRIX      Modules,
-  IN OUT QR_FUNCTION_MATRIX    FunctionModules,
-  IN     CONST UINT8          *Centers,
-  IN     UINTN                 CenterCount,
-  IN     UINTN                 Size
+GetRmqrFormatPosition(
+  IN  UINTN   Bit,
+  IN  BOOLEAN SubFinder,
+  IN  UINTN   Width,
+  IN  UINTN   Height,
+  OUT UINTN  *X,
+  OUT UINTN  *Y
   )
 {
-  if ((Centers == NULL) || (CenterCount == 0)) {
-    return;
+  if (!SubFinder) {
+    *X = (Bit < 15) ? (8 + (Bit / 5)) : 11;
+    *Y = (Bit < 15) ? (1 + (Bit % 5)) : (1 + (Bit - 15));
+  } else {
+    *X = (Bit < 15) ? (Width - 8 + (Bit / 5)) : (Width - 5 + (Bit - 15));
+    *Y = (Bit < 15) ? (Height - 6 + (Bit % 5)) : (Height - 6);
   }
+}
 
-  UINT8 LastCenter = Centers[CenterCount - 1];
+STATIC
+VOID
+DrawRmqrFunctionPatterns(
+  IN OUT UINT64 Modules[][QR_ROW_WORDS],
+  IN OUT UINT64 FunctionModules[][QR_ROW_WORDS],
+  IN     UINTN  Width,
+  IN     UINTN  Height
+  )
+{
+  CONST UINT8 *Columns = NULL;
+  for (UINTN Index = 0; Index < ARRAY_SIZE(mRmqrAlignmentColumns); Index++) {
+    if (mRmqrAlignmentColumns[Index][0] == Width) {
+      Columns = &mRmqrAlignmentColumns[Index][1];
+    }
+  }
 
-  for (UINTN YIndex = 0; YIndex < CenterCount; YIndex++) {
-    for (UINTN XIndex = 0; XIndex < CenterCount; XIndex++) {
-      UINT8 CenterX = Centers[XIndex];
-      UINT8 CenterY = Centers[YIndex];
+  //
+  // Timing patterns first; the patterns drawn after them take precedence
+  // where they overlap.
+  //
+  for (UINTN X = 0; X < Width; X++) {
+    QrSetFunctionModule(Modules, FunctionModules, X, 0, (BOOLEAN)((X % 2) == 0));
+    QrSetFunctionModule(Modules, FunctionModules, X, Height - 1, (BOOLEAN)((X % 2) == 0));
+  }
 
-      if (((CenterX == 6) && (CenterY == 6)) ||
-          ((CenterX == 6) && (CenterY == LastCenter)) ||
-          ((CenterX == LastCenter) && (CenterY == 6))) {
-        continue;
+  for (UINTN Y = 0; Y < Height; Y++) {
+    QrSetFunctionModule(Modules, FunctionModules, 0, Y, (BOOLEAN)((Y % 2) == 0));
+    QrSetFunctionModule(Modules, FunctionModules, Width - 1, Y, (BOOLEAN)((Y % 2) == 0));
+    for (UINTN Index = 0; (Columns != NULL) && (Index < 4) && (Columns[Index] != 0); Index++) {
+      QrSetFunctionModule(Modules, FunctionModules, Columns[Index], Y, (BOOLEAN)((Y % 2) == 0));
+    }
+  }
+
+  for (UINTN Index = 0; (Columns != NULL) && (Index < 4) && (Columns[Index] != 0); Index++) {
+    for (UINTN Dy = 0; Dy < 3; Dy++) {
+      for (UINTN Dx = 0; Dx < 3; Dx++) {
+        BOOLEAN Dark = (BOOLEAN)((Dx != 1) || (Dy != 1));
+        QrSetFunctionModule(Modules, FunctionModules, Columns[Index] - 1 + Dx, Dy, Dark);
+        QrSetFunctionModule(Modules, FunctionModules, Columns[Index] - 1 + Dx, Height - 3 + Dy, Dark);
       }
+    }
+  }
 
-      DrawAlignmentPattern(Modules, FunctionModules, CenterX, CenterY, Size);
+  //
+  // Finder pattern and separator. Symbols seven modules high have no room
+  // for the separator row.
+  //
+  for (UINTN Y = 0; Y < MIN(Height, 8); Y++) {
+    for (UINTN X = 0; X < 8; X++) {
+      UINTN   Ring = MAX((X > 3) ? X - 3 : 3 - X, (Y > 3) ? Y - 3 : 3 - Y);
+      BOOLEAN Dark = (BOOLEAN)((X < 7) && (Y < 7) && (Ring != 2));
+      QrSetFunctionModule(Modules, FunctionModules, X, Y, Dark);
     }
   }
+
+  for (UINTN Y = 0; Y < 5; Y++) {
+    for (UINTN X = 0; X < 5; X++) {
+      UINTN Ring = MAX((X > 2) ? X - 2 : 2 - X, (Y > 2) ? Y - 2 : 2 - Y);
+      QrSetFunctionModule(Modules, FunctionModules, Width - 5 + X, Height - 5 + Y, (BOOLEAN)(Ring != 1));
+    }
+  }
+
+  //
+  // Corner finder sub-patterns. The bottom left one shrinks to its bottom
+  // row on symbols too short to fit it below the finder pattern.
+  //
+  QrSetFunctionModule(Modules, FunctionModules, Width - 1, 0, TRUE);
+  QrSetFunctionModule(Modules, FunctionModules, Width - 2, 0, TRUE);
+  QrSetFunctionModule(Modules, FunctionModules, Width - 1, 1, TRUE);
+  QrSetFunctionModule(Modules, FunctionModules, Width - 2, 1, FALSE);
+
+  for (UINTN X = 0; X < 3; X++) {
+    QrSetFunctionModule(Modules, FunctionModules, X, Height - 1, TRUE);
+  }
+
+  if (Height >= 11) {
+    QrSetFunctionModule(Modules, FunctionModules, 0, Height - 2, TRUE);
+    QrSetFunctionModule(Modules, FunctionModules, 1, Height - 2, FALSE);
+  }
+
+  for (UINTN Bit = 0; Bit < RMQR_FORMAT_BITS; Bit++) {
+    UINTN X;
+    UINTN Y;
+
+    GetRmqrFormatPosition(Bit, FALSE, Width, Height, &X, &Y);
+    QrMatrixSet(FunctionModules, X, Y, TRUE);
+    GetRmqrFormatPosition(Bit, TRUE, Width, Height, &X, &Y);
+    QrMatrixSet(FunctionModules, X, Y, TRUE);
+  }
 }
 
+//
+// Format information is the level (Medium 0, High 1) and the version
+// indicator, BCH coded and masked differently on each side.
+//
 STATIC
 VOID
-DrawTimingPatterns(
-  IN OUT QR_MODULE_MATRIX      Modules,
-  IN OUT QR_FUNCTION_MATRIX    FunctionModules,
-  IN     UINTN                 Size
+DrawRmqrFormatBits(
+  IN OUT UINT64 Modules[][QR_ROW_WORDS],
+  IN     UINTN  Version,
+  IN     UINTN  Level,
+  IN     UINTN  Width,
+  IN     UINTN  Height
   )
 {
-  for (INTN Index = 0; Index < (INTN)Size; Index++) {
-    if (!FunctionModules[6][Index]) {
-      Modules[6][Index] = (INT8)((Index % 2) == 0);
-      FunctionModules[6][Index] = TRUE;
+  UINT32 Format = ComputeBchCode18((UINT32)((Level << 5) | Version));
+
+  for (UINTN Bit = 0; Bit < RMQR_FORMAT_BITS; Bit++) {
+    UINTN X;
+    UINTN Y;
+
+    GetRmqrFormatPosition(Bit, FALSE, Width, Height, &X, &Y);
+    QrMatrixSet(Modules, X, Y, (BOOLEAN)(((Format ^ RMQR_FINDER_FORMAT_MASK) >> Bit) & 0x1));
+    GetRmqrFormatPosition(Bit, TRUE, Width, Height, &X, &Y);
+    QrMatrixSet(Modules, X, Y, (BOOLEAN)(((Format ^ RMQR_SUBFINDER_FORMAT_MASK) >> Bit) & 0x1));
+  }
+}
+
+STATIC
+CONST QR_RMQR_TEMPLATE *
+GetRmqrTemplate(
+  IN UINTN Version
+  )
+{
+  if (mRmqrTemplates[Version] != NULL) {
+    return mRmqrTemplates[Version];
+  }
+
+  UINTN EntryCount = (UINTN)mRmqrVersions[Version].TotalCodewords * 8;
+  QR_RMQR_TEMPLATE *Template = AllocateZeroPool(sizeof(*Template) + EntryCount * sizeof(QR_PLACEMENT_ENTRY));
+  if (Template == NULL) {
+    return NULL;
+  }
+
+  Template->Width  = mRmqrVersions[Version].Width;
+  Template->Height = mRmqrVersions[Version].Height;
+
+  DrawRmqrFunctionPatterns(Template->BaseModules, Template->FunctionModules, Template->Width, Template->Height);
+  BuildMaskPlane(Template->FunctionModules, RMQR_MASK, Template->Width, Template->Height, Template->MaskPlane);
+  BuildPlacementTable(Template->FunctionModules, Template->Height, Template->Width - 2, Template->Placement, EntryCount);
+
+  if (InterlockedCompareExchangePointer((VOID **)&mRmqrTemplates[Version], NULL, Template) != NULL) {
+    FreePool(Template);
+  }
+
+  return mRmqrTemplates[Version];
+}
+
+EFI_STATUS
+PrecomputeComputerInfoQrTemplates(
+  VOID
+  )
+{
+  for (UINTN Version = COMPUTER_INFO_QR_MIN_VERSION; Version <= COMPUTER_INFO_QR_MAX_VERSION; Version++) {
+    if (GetVersionTemplate(Version) == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  for (UINTN Version = 0; Version < COMPUTER_INFO_QR_RMQR_VERSION_COUNT; Version++) {
+    if (GetRmqrTemplate(Version) == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+VOID
+FreeComputerInfoQrCaches(
+  VOID
+  )
+{
+  for (UINTN Slot = 0; Slot < ARRAY_SIZE(mVersionTemplates); Slot++) {
+    if (mVersionTemplates[Slot] != NULL) {
+      FreePool(mVersionTemplates[Slot]);
+      mVersionTemplates[Slot] = NULL;
     }
-    if (!FunctionModules[Index][6]) {
-      Modules[Index][6] = (INT8)((Index % 2) == 0);
-      FunctionModules[Index][6] = TRUE;
+  }
+
+  for (UINTN Slot = 0; Slot < ARRAY_SIZE(mRmqrTemplates); Slot++) {
+    if (mRmqrTemplates[Slot] != NULL) {
+      FreePool(mRmqrTemplates[Slot]);
+      mRmqrTemplates[Slot] = NULL;
     }
   }
 }
 
+//
+// Penalty scoring works directly on packed row words. Horizontal features are
+// found by shifting a row against itself; vertical features by combining the
+// same word of consecutive rows, which scores every column of the word at
+// once without a transposed copy.
+//
+typedef struct {
+  UINTN  Size;
+  UINTN  Words;
+  UINT64 ColumnMask[QR_ROW_WORDS];
+  UINT64 BlockMask[QR_ROW_WORDS];
+  UINT64 RunMask[QR_ROW_WORDS];
+  UINT64 FinderMask[QR_ROW_WORDS];
+} QR_PENALTY_MASKS;
+
 STATIC
 VOID
-ReserveFormatInfo(
-  IN OUT QR_FUNCTION_MATRIX FunctionModules,
-  IN     UINTN              Size
+QrBuildValidMask(
+  OUT UINT64 *Mask,
+  IN  UINTN   Size,
+  IN  UINTN   Lookahead
   )
 {
-  for (INTN Index = 0; Index <= 8; Index++) {
-    if (Index != 6) {
-      FunctionModules[8][Index] = TRUE;
-      FunctionModules[Index][8] = TRUE;
+  UINTN Limit = (Size > Lookahead) ? (Size - Lookahead) : 0;
+
+  for (UINTN Word = 0; Word < QR_ROW_WORDS; Word++) {
+    UINTN Start = Word * 64;
+    if (Limit <= Start) {
+      Mask[Word] = 0;
+    } else if (Limit - Start >= 64) {
+      Mask[Word] = MAX_UINT64;
+    } else {
+      Mask[Word] = ((UINT64)1 << (Limit - Start)) - 1;
     }
   }
+}
 
-  for (INTN Index = 0; Index < 7; Index++) {
-    FunctionModules[8][(INTN)Size - 1 - Index] = TRUE;
-    FunctionModules[(INTN)Size - 1 - Index][8] = TRUE;
+STATIC
+VOID
+InitializePenaltyMasks(
+  OUT QR_PENALTY_MASKS *Masks,
+  IN  UINTN             Size
+  )
+{
+  Masks->Size  = Size;
+  Masks->Words = QrRowWords(Size);
+  QrBuildValidMask(Masks->ColumnMask, Size, 0);
+  QrBuildValidMask(Masks->BlockMask, Size, 1);
+  QrBuildValidMask(Masks->RunMask, Size, 4);
+  QrBuildValidMask(Masks->FinderMask, Size, 10);
+}
+
+//
+// Bit J of a run word is set when modules J..J+4 share a colour. A run of
+// length N >= 5 sets N - 4 consecutive bits, so its 3 + (N - 5) penalty is
+// the bit count plus two for each run start.
+//
+STATIC
+UINT64
+QrRunWord(
+  IN UINT64 X0,
+  IN UINT64 X1,
+  IN UINT64 X2,
+  IN UINT64 X3,
+  IN UINT64 X4
+  )
+{
+  return ~(X0 ^ X1) & ~(X1 ^ X2) & ~(X2 ^ X3) & ~(X3 ^ X4);
+}
+
+//
+// Finder-like windows are 1011101 followed by four light modules, or the
+// exact inverse of that pattern. X0..X10 are the eleven window positions.
+//
+STATIC
+UINT64
+QrFinderWord(
+  IN CONST UINT64 *X
+  )
+{
+  UINT64 Core = ~(X[0] ^ X[2]);
+  UINT64 Pattern = Core & ~X[1] & X[2] & X[3] & X[4];
+  UINT64 Inverse = Core & X[1] & ~(X[2] | X[3] | X[4]);
+
+  if ((Pattern | Inverse) == 0) {
+    return 0;
   }
 
-  FunctionModules[8][(INTN)Size - 8] = TRUE;
-  FunctionModules[(INTN)Size - 8][8] = TRUE;
+  Pattern &= ~X[5] & X[6] & ~(X[7] | X[8] | X[9] | X[10]);
+  Inverse &= X[5] & ~X[6] & (X[7] & X[8] & X[9] & X[10]);
+  return Pattern | Inverse;
 }
 
 STATIC
-BOOLEAN
-IsFunctionModule(
-  IN CONST QR_FUNCTION_MATRIX FunctionModules,
-  IN INTN                     X,
-  IN INTN                     Y,
-  IN UINTN                    Size
+INT32
+ScoreRowPenalty(
+  IN CONST UINT64           *Row,
+  IN CONST QR_PENALTY_MASKS *Masks
   )
 {
-  if (X < 0 || Y < 0 || X >= (INTN)Size || Y >= (INTN)Size) {
-    return TRUE;
+  UINT64 PreviousRuns = 0;
+  UINTN  RunBits      = 0;
+  UINTN  RunStarts    = 0;
+  UINTN  Finders      = 0;
+
+  for (UINTN Word = 0; Word < Masks->Words; Word++) {
+    UINT64 Next = (Word + 1 < Masks->Words) ? Row[Word + 1] : 0;
+    UINT64 X[11];
+
+    X[0] = Row[Word];
+    for (UINTN Shift = 1; Shift < 11; Shift++) {
+      X[Shift] = (X[0] >> Shift) | (Next << (64 - Shift));
+    }
+
+    UINT64 Runs = QrRunWord(X[0], X[1], X[2], X[3], X[4]) & Masks->RunMask[Word];
+    if (Runs != 0) {
+      RunBits   += QrPopCount64(Runs);
+      RunStarts += QrPopCount64(Runs & ~((Runs << 1) | (PreviousRuns >> 63)));
+    }
+    PreviousRuns = Runs;
+
+    UINT64 Finder = QrFinderWord(X) & Masks->FinderMask[Word];
+    if (Finder != 0) {
+      Finders += QrPopCount64(Finder);
+    }
   }
-  return FunctionModules[Y][X];
+
+  return (INT32)(RunBits + (RunStarts * 2) + (Finders * 40));
 }
 
+//
+// Ten points for every full 5% the share of dark modules is away from half.
+//
 STATIC
-VOID
-PlaceDataBits(
-  IN OUT QR_MODULE_MATRIX            Modules,
-  IN     CONST QR_FUNCTION_MATRIX    FunctionModules,
-  IN     CONST UINT8                *Bits,
-  IN     UINTN                       BitCount,
-  IN     UINTN                       Size
+INT32
+ScoreDarkBalance(
+  IN CONST QR_MODULE_MATRIX Modules,
+  IN UINTN                  Size
   )
 {
-  UINTN BitIndex = 0;
-  BOOLEAN GoingUp = TRUE;
+  UINTN Words     = QrRowWords(Size);
+  UINTN DarkCount = 0;
 
-  for (INTN Column = (INTN)Size - 1; Column > 0; Column -= 2) {
-    if (Column == 6) {
-      Column--;
+  for (UINTN Y = 0; Y < Size; Y++) {
+    for (UINTN Word = 0; Word < Words; Word++) {
+      DarkCount += QrPopCount64(Modules[Y][Word]);
     }
+  }
 
-    for (INTN Offset = 0; Offset < (INTN)Size; Offset++) {
-      INTN Row = GoingUp ? ((INTN)Size - 1 - Offset) : Offset;
+  UINTN TotalModules = Size * Size;
+  INTN Percent = (INTN)((DarkCount * 100 + TotalModules / 2) / TotalModules);
+  INTN FivePercent = ABS(Percent - 50) / 5;
+  return (INT32)FivePercent * 10;
+}
 
-      for (INTN ColumnOffset = 0; ColumnOffset < 2; ColumnOffset++) {
-        INTN CurrentColumn = Column - ColumnOffset;
-        if (IsFunctionModule(FunctionModules, CurrentColumn, Row, Size)) {
-          continue;
+//
+// Adds every feature that starts on a row to Balance, the candidate's
+// ScoreDarkBalance, row by row. Each row only adds to the total, so once the
+// running total exceeds Bound the candidate cannot beat the mask that set it
+// and scoring stops. The return value is then some partial total above Bound
+// rather than the exact penalty.
+//
+STATIC
+INT32
+EvaluatePenaltyBounded(
+  IN CONST QR_MODULE_MATRIX Modules,
+  IN UINTN                  Size,
+  IN INT32                  Balance,
+  IN INT32                  Bound
+  )
+{
+  QR_PENALTY_MASKS Masks;
+  UINT64           PreviousColumnRuns[QR_ROW_WORDS];
+  UINTN            RunBits   = 0;
+  UINTN            RunStarts = 0;
+  UINTN            Blocks    = 0;
+  UINTN            Finders   = 0;
+  INT32            Penalty   = Balance;
+
+  if (Penalty > Bound) {
+    return Penalty;
+  }
+
+  InitializePenaltyMasks(&Masks, Size);
+  ZeroMem(PreviousColumnRuns, sizeof(PreviousColumnRuns));
+
+  for (UINTN Y = 0; Y < Size; Y++) {
+    Penalty += ScoreRowPenalty(Modules[Y], &Masks);
+
+    for (UINTN Word = 0; Word < Masks.Words; Word++) {
+      UINT64 Row = Modules[Y][Word];
+
+      if (Y + 1 < Size) {
+        UINTN  NextWord = Word + 1;
+        UINT64 Below    = Modules[Y + 1][Word];
+        UINT64 RowNext  = (NextWord < Masks.Words) ? Modules[Y][NextWord] : 0;
+        UINT64 BelowNext = (NextWord < Masks.Words) ? Modules[Y + 1][NextWord] : 0;
+        UINT64 RowRight   = (Row >> 1) | (RowNext << 63);
+        UINT64 BelowRight = (Below >> 1) | (BelowNext << 63);
+        UINT64 Same = ~(Row ^ RowRight) & ~(Row ^ Below) & ~(Below ^ BelowRight) & Masks.BlockMask[Word];
+        if (Same != 0) {
+          Blocks += QrPopCount64(Same);
         }
+      }
+
+      UINT64 Runs = 0;
+      if (Y + 4 < Size) {
+        Runs = QrRunWord(
+                 Row,
+                 Modules[Y + 1][Word],
+                 Modules[Y + 2][Word],
+                 Modules[Y + 3][Word],
+                 Modules[Y + 4][Word]
+                 ) & Masks.ColumnMask[Word];
+        if (Runs != 0) {
+          RunBits   += QrPopCount64(Runs);
+          RunStarts += QrPopCount64(Runs & ~PreviousColumnRuns[Word]);
+        }
+      }
+      PreviousColumnRuns[Word] = Runs;
 
-        UINT8 BitValue = 0;
-        if (BitIndex < BitCount) {
-          BitValue = Bits[BitIndex];
+      if (Y + 10 < Size) {
+        UINT64 X[11];
+        for (UINTN Offset = 0; Offset < 11; Offset++) {
+          X[Offset] = Modules[Y + Offset][Word];
+        }
+
+        UINT64 Finder = QrFinderWord(X) & Masks.ColumnMask[Word];
+        if (Finder != 0) {
+          Finders += QrPopCount64(Finder);
         }
-        Modules[Row][CurrentColumn] = (INT8)BitValue;
-        BitIndex++;
       }
     }
 
-    GoingUp = !GoingUp;
+    INT32 Total = Penalty + (INT32)(RunBits + (RunStarts * 2) + (Blocks * 3) + (Finders * 40));
+    if (Total > Bound) {
+      return Total;
+    }
   }
+
+  return Penalty + (INT32)(RunBits + (RunStarts * 2) + (Blocks * 3) + (Finders * 40));
 }
 
+typedef struct {
+  CONST QR_MODULE_MATRIX   *BaseModules;
+  CONST UINT64             (*MaskPlanes)[QR_ROW_WORDS];
+  UINTN                    Size;
+  UINTN                    Level;
+  QR_MODULE_MATRIX         *Candidates;
+  INT32                    Balances[QR_MASK_COUNT];
+  UINT8                    Order[QR_MASK_COUNT];
+  volatile UINT32          BestPenalty;
+  INT32                    Penalties[QR_MASK_COUNT];
+} QR_MASK_SEARCH;
+
+//
+// First pass: builds one mask candidate in its own scratch matrix and scores
+// its dark balance, which is both the first term of its penalty and the cheap
+// predictor the second pass is ordered by. Candidates share only read-only
+// inputs, so a backend may run them concurrently.
+//
 STATIC
-UINT8
-MaskBit(
-  IN UINTN Mask,
-  IN INTN  X,
-  IN INTN  Y
+VOID
+EFIAPI
+PrepareMaskCandidate(
+  IN VOID  *Context,
+  IN UINTN  Mask
   )
 {
-  switch (Mask) {
-  case 0:
-    return (UINT8)(((X + Y) & 0x1) == 0);
-  case 1:
-    return (UINT8)((Y & 0x1) == 0);
-  case 2:
-    return (UINT8)((X % 3) == 0);
-  case 3:
-    return (UINT8)(((X + Y) % 3) == 0);
-  case 4:
-    return (UINT8)((((Y / 2) + (X / 3)) & 0x1) == 0);
-  case 5:
-    return (UINT8)((((X * Y) % 2) + ((X * Y) % 3)) == 0);
-  case 6:
-    return (UINT8)(((((X * Y) % 2) + ((X * Y) % 3)) & 0x1) == 0);
-  case 7:
-    return (UINT8)(((((X + Y) % 2) + ((X * Y) % 3)) & 0x1) == 0);
-  default:
-    return 0;
+  QR_MASK_SEARCH   *Search    = (QR_MASK_SEARCH *)Context;
+  QR_MODULE_MATRIX *Candidate = &Search->Candidates[Mask];
+
+  QR_STAGE_BEGIN(Mask);
+  ApplyMask(*Candidate, *Search->BaseModules, &Search->MaskPlanes[Mask * Search->Size], Search->Size);
+  DrawFormatBits(*Candidate, Search->Level, Mask, Search->Size);
+  QR_STAGE_END(Mask);
+
+  QR_STAGE_BEGIN(Penalty);
+  Search->Balances[Mask] = ScoreDarkBalance(*Candidate, Search->Size);
+  QR_STAGE_END(Penalty);
+}
+
+//
+// Second pass: scores the candidates in predicted order against the best
+// penalty found so far. Concurrent workers may read a stale bound, which
+// only means less pruning; a candidate is abandoned only once its partial
+// total is strictly above a penalty some other mask reached, so it can
+// neither win nor tie.
+//
+STATIC
+VOID
+EFIAPI
+ScoreMaskCandidate(
+  IN VOID  *Context,
+  IN UINTN  Candidate
+  )
+{
+  QR_MASK_SEARCH *Search  = (QR_MASK_SEARCH *)Context;
+  UINTN          Mask     = Search->Order[Candidate];
+
+  QR_STAGE_BEGIN(Penalty);
+  INT32          Penalty  = EvaluatePenaltyBounded(
+                              Search->Candidates[Mask],
+                              Search->Size,
+                              Search->Balances[Mask],
+                              (INT32)Search->BestPenalty
+                              );
+  QR_STAGE_END(Penalty);
+
+  Search->Penalties[Mask] = Penalty;
+
+  UINT32 Current = Search->BestPenalty;
+  while ((UINT32)Penalty < Current) {
+    UINT32 Seen = InterlockedCompareExchange32(&Search->BestPenalty, Current, (UINT32)Penalty);
+    if (Seen == Current) {
+      break;
+    }
+
+    Current = Seen;
+  }
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+DispatchMaskCandidatesSerial(
+  IN VOID                          *BackendContext,
+  IN COMPUTER_INFO_QR_MASK_WORKER   Worker,
+  IN VOID                          *WorkerContext,
+  IN UINTN                          CandidateCount
+  )
+{
+  (VOID)BackendContext;
+
+  for (UINTN Candidate = 0; Candidate < CandidateCount; Candidate++) {
+    Worker(WorkerContext, Candidate);
   }
+
+  return EFI_SUCCESS;
 }
 
+STATIC COMPUTER_INFO_QR_MASK_SEARCH_BACKEND mMaskSearchBackend = {
+  DispatchMaskCandidatesSerial,
+  NULL
+};
+
+//
+// AVX2 is only used while the serial backend runs every candidate on the
+// calling CPU. Another backend may hand candidates to APs whose XCR0 does not
+// enable the AVX state, so it gets SSE2, which every X64 CPU runs.
+//
 STATIC
 VOID
-ApplyMask(
-  IN OUT QR_MODULE_MATRIX         Modules,
-  IN     CONST QR_FUNCTION_MATRIX FunctionModules,
-  IN     UINTN                    Mask,
-  IN     UINTN                    Size
+SelectXorWords(
+  VOID
   )
 {
-  for (INTN Y = 0; Y < (INTN)Size; Y++) {
-    for (INTN X = 0; X < (INTN)Size; X++) {
-      if (FunctionModules[Y][X]) {
-        continue;
-      }
-      if (MaskBit(Mask, X, Y)) {
-        Modules[Y][X] ^= 1;
-      }
+#if defined (MDE_CPU_X64) && defined (__GNUC__)
+  if ((mMaskSearchBackend.Dispatch == DispatchMaskCandidatesSerial) && QrCpuSupportsAvx2()) {
+    mXorWords = XorWordsAvx2;
+  } else {
+    mXorWords = XorWordsSse2;
+  }
+#else
+  mXorWords = XorWordsPortable;
+#endif
+}
+
+VOID
+SetComputerInfoQrMaskSearchBackend(
+  IN CONST COMPUTER_INFO_QR_MASK_SEARCH_BACKEND *Backend OPTIONAL
+  )
+{
+  if ((Backend == NULL) || (Backend->Dispatch == NULL)) {
+    mMaskSearchBackend.Dispatch = DispatchMaskCandidatesSerial;
+    mMaskSearchBackend.Context  = NULL;
+  } else {
+    mMaskSearchBackend = *Backend;
+  }
+
+  SelectXorWords();
+}
+
+STATIC
+VOID
+DispatchMaskCandidates(
+  IN     COMPUTER_INFO_QR_MASK_WORKER  Worker,
+  IN OUT QR_MASK_SEARCH               *Search
+  )
+{
+  EFI_STATUS Status;
+
+  Status = mMaskSearchBackend.Dispatch(
+                                mMaskSearchBackend.Context,
+                                Worker,
+                                Search,
+                                QR_MASK_COUNT
+                                );
+  if (EFI_ERROR(Status)) {
+    DispatchMaskCandidatesSerial(NULL, Worker, Search, QR_MASK_COUNT);
+  }
+}
+
+STATIC
+UINTN
+SelectBestMask(
+  IN OUT QR_MASK_SEARCH *Search
+  )
+{
+  DispatchMaskCandidates(PrepareMaskCandidate, Search);
+
+  //
+  // Best balanced masks first, so the bound is tight early. A full penalty
+  // would predict better, but sampling even a quarter of the rows pruned no
+  // more than the balance alone on host benchmarks.
+  //
+  for (UINTN Mask = 0; Mask < QR_MASK_COUNT; Mask++) {
+    UINTN Position = Mask;
+    while ((Position > 0) && (Search->Balances[Search->Order[Position - 1]] > Search->Balances[Mask])) {
+      Search->Order[Position] = Search->Order[Position - 1];
+      Position--;
+    }
+
+    Search->Order[Position] = (UINT8)Mask;
+  }
+
+  Search->BestPenalty = MAX_INT32;
+  DispatchMaskCandidates(ScoreMaskCandidate, Search);
+
+  //
+  // Reduce in mask order so ties go to the lowest mask index, exactly as an
+  // exhaustive search would pick them.
+  //
+  UINTN BestMask = 0;
+  for (UINTN Mask = 1; Mask < QR_MASK_COUNT; Mask++) {
+    if (Search->Penalties[Mask] < Search->Penalties[BestMask]) {
+      BestMask = Mask;
     }
   }
+
+  return BestMask;
+}
+
+//
+// Everything an encode writes to, carved out of one allocation that is sized
+// for COMPUTER_INFO_QR_MAX_VERSION and reused by every encode through the
+// same context.
+//
+typedef struct {
+  QR_SEGMENT_TRACE SegmentTrace[COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH];
+  QR_SEGMENT       Segments[COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH];
+  UINT8            DataCodewords[COMPUTER_INFO_QR_MAX_DATA_CODEWORDS];
+  UINT8            Codewords[COMPUTER_INFO_QR_MAX_TOTAL_CODEWORDS];
+  QR_MODULE_MATRIX BaseModules;
+  QR_MODULE_MATRIX Candidates[QR_MASK_COUNT];
+  //
+  // Reed-Solomon rows for the generator this context used last.
+  //
+  QR_RS_PRODUCT_TABLE RsProducts;
+  //
+  // The last finished symbol is Candidates[SymbolMask]; SymbolWidth is zero
+  // while there is none.
+  //
+  UINTN            SymbolWidth;
+  UINTN            SymbolHeight;
+  UINTN            SymbolMask;
+} QR_ENCODER_ARENA;
+
+EFI_STATUS
+InitializeComputerInfoQrEncoder(
+  OUT COMPUTER_INFO_QR_ENCODER_CONTEXT *Context
+  )
+{
+  if (Context == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Context->Arena = AllocateZeroPool(sizeof(QR_ENCODER_ARENA));
+  if (Context->Arena == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  SelectXorWords();
+  return EFI_SUCCESS;
+}
+
+VOID
+FreeComputerInfoQrEncoder(
+  IN OUT COMPUTER_INFO_QR_ENCODER_CONTEXT *Context
+  )
+{
+  if ((Context != NULL) && (Context->Arena != NULL)) {
+    FreePool(Context->Arena);
+    Context->Arena = NULL;
+  }
 }
 
+//
+// Turns the segments in Arena->Segments into a finished symbol at the given
+// version and level, kept in the arena and copied to QrCode when given.
+//
 STATIC
-UINT16
-CalculateFormatBits(
-  IN UINTN Mask
+EFI_STATUS
+EncodeSegmentedSymbol(
+  IN OUT QR_ENCODER_ARENA           *Arena,
+  IN     CONST UINT8                *Payload,
+  IN     UINTN                       SegmentCount,
+  IN     CONST QR_STRUCTURED_APPEND *StructuredAppend OPTIONAL,
+  IN     UINTN                       Version,
+  IN     UINTN                       Level,
+  OUT    COMPUTER_INFO_QR_CODE      *QrCode OPTIONAL
   )
 {
-  UINT16 Format = 0;
-  UINT16 Data = (UINT16)((0x01 << 3) | (Mask & 0x7));
-  Format = (UINT16)(Data << 10);
+  EFI_STATUS       Status;
+  QR_MASK_SEARCH   Search;
 
-  UINT16 Polynomial = 0x537;
-  for (INTN Bit = 14; Bit >= 10; Bit--) {
-    if ((Format >> Bit) & 0x1) {
-      Format ^= (UINT16)(Polynomial << (Bit - 10));
-    }
+  Arena->SymbolWidth = 0;
+
+  UINTN Size = 4 * Version + 17;
+  UINTN DataCapacity = GetDataCodewordCapacity(Version, Level);
+  UINTN TotalCodewords = GetTotalCodewords(Version);
+  UINTN NumBlocks = GetNumErrorCorrectionBlocks(Version, Level);
+  UINTN EccCodewordsPerBlock = GetEccCodewordsPerBlock(Version, Level);
+
+  QR_STAGE_BEGIN(DataCodewords);
+  Status = BuildDataCodewords(
+             Payload,
+             Arena->Segments,
+             SegmentCount,
+             StructuredAppend,
+             Version,
+             Arena->DataCodewords,
+             DataCapacity
+             );
+  QR_STAGE_END(DataCodewords);
+  if (EFI_ERROR(Status)) {
+    return Status;
   }
 
-  Format = (UINT16)((Data << 10) | Format);
-  Format ^= 0x5412;
-  return Format;
+  Status = BuildCodewordSequence(
+             Arena->DataCodewords,
+             DataCapacity,
+             TotalCodewords,
+             NumBlocks,
+             EccCodewordsPerBlock,
+             &Arena->RsProducts,
+             Arena->Codewords
+             );
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  CONST QR_VERSION_TEMPLATE *Template = GetVersionTemplate(Version);
+  if (Template == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  QR_STAGE_BEGIN(Placement);
+  QrMatrixCopy(Arena->BaseModules, Template->BaseModules, Size);
+  PlaceCodewords(Arena->BaseModules, Template->Placement, Arena->Codewords, TotalCodewords);
+  QR_STAGE_END(Placement);
+
+  Search.BaseModules     = (CONST QR_MODULE_MATRIX *)&Arena->BaseModules;
+  Search.MaskPlanes      = Template->MaskPlanes;
+  Search.Size            = Size;
+  Search.Level           = Level;
+  Search.Candidates      = Arena->Candidates;
+
+  UINTN BestMask = SelectBestMask(&Search);
+
+  Arena->SymbolWidth  = Size;
+  Arena->SymbolHeight = Size;
+  Arena->SymbolMask   = BestMask;
+
+  if (QrCode != NULL) {
+    ZeroMem(QrCode->Modules, sizeof(QrCode->Modules));
+    QrMatrixCopy(QrCode->Modules, Arena->Candidates[BestMask], Size);
+    QrCode->Width    = Size;
+    QrCode->Height   = Size;
+    QrCode->EccLevel = (COMPUTER_INFO_QR_ECC_LEVEL)Level;
+  }
+
+  return EFI_SUCCESS;
 }
 
+//
+// The rMQR counterpart of EncodeSegmentedSymbol. Version is the version
+// indicator and Level 0 for Medium or 1 for High. With a single mask the
+// symbol is simply masked into Candidates[0].
+//
 STATIC
-VOID
-DrawFormatBits(
-  IN OUT QR_MODULE_MATRIX      Modules,
-  IN OUT QR_FUNCTION_MATRIX    FunctionModules,
-  IN     UINTN                 Mask,
-  IN     UINTN                 Size
+EFI_STATUS
+EncodeRmqrSymbol(
+  IN OUT QR_ENCODER_ARENA      *Arena,
+  IN     CONST UINT8           *Payload,
+  IN     UINTN                  SegmentCount,
+  IN     UINTN                  Version,
+  IN     UINTN                  Level,
+  OUT    COMPUTER_INFO_QR_CODE *QrCode OPTIONAL
   )
 {
-  UINT16 Format = CalculateFormatBits(Mask);
+  EFI_STATUS Status;
 
-  CONST INTN HorizontalPositions[8] = { 0, 1, 2, 3, 4, 5, 7, 8 };
-  CONST INTN VerticalPositions[8]   = { 0, 1, 2, 3, 4, 5, 7, 8 };
+  Arena->SymbolWidth = 0;
 
-  for (INTN Index = 0; Index < 8; Index++) {
-    UINT8 Bit = (UINT8)((Format >> Index) & 0x1);
-    INTN  Row = VerticalPositions[Index];
-    Modules[Row][8] = (INT8)Bit;
-    FunctionModules[Row][8] = TRUE;
+  UINTN DataCapacity   = mRmqrDataCodewordCapacity[Level][Version];
+  UINTN TotalCodewords = mRmqrVersions[Version].TotalCodewords;
+
+  QR_STAGE_BEGIN(DataCodewords);
+  Status = BuildRmqrDataCodewords(
+             Payload,
+             Arena->Segments,
+             SegmentCount,
+             Version,
+             Arena->DataCodewords,
+             DataCapacity
+             );
+  QR_STAGE_END(DataCodewords);
+  if (EFI_ERROR(Status)) {
+    return Status;
   }
 
-  for (INTN Index = 0; Index < 8; Index++) {
-    UINT8 Bit = (UINT8)((Format >> (14 - Index)) & 0x1);
-    INTN  Column = HorizontalPositions[Index];
-    Modules[8][Column] = (INT8)Bit;
-    FunctionModules[8][Column] = TRUE;
+  Status = BuildCodewordSequence(
+             Arena->DataCodewords,
+             DataCapacity,
+             TotalCodewords,
+             mRmqrNumErrorCorrectionBlocks[Level][Version],
+             mRmqrEccCodewordsPerBlock[Level][Version],
+             &Arena->RsProducts,
+             Arena->Codewords
+             );
+  if (EFI_ERROR(Status)) {
+    return Status;
   }
 
-  for (INTN Index = 0; Index < 8; Index++) {
-    UINT8 Bit = (UINT8)((Format >> Index) & 0x1);
-    INTN  Column = (INTN)Size - 1 - Index;
-    Modules[8][Column] = (INT8)Bit;
-    FunctionModules[8][Column] = TRUE;
+  CONST QR_RMQR_TEMPLATE *Template = GetRmqrTemplate(Version);
+  if (Template == NULL) {
+    return EFI_OUT_OF_RESOURCES;
   }
 
-  for (INTN Index = 0; Index < 8; Index++) {
-    UINT8 Bit = (UINT8)((Format >> (14 - Index)) & 0x1);
-    INTN  Row = (INTN)Size - 1 - Index;
-    Modules[Row][8] = (INT8)Bit;
-    FunctionModules[Row][8] = TRUE;
+  UINTN Width  = Template->Width;
+  UINTN Height = Template->Height;
+
+  QR_STAGE_BEGIN(Placement);
+  QrMatrixCopy(Arena->BaseModules, Template->BaseModules, Height);
+  PlaceCodewords(Arena->BaseModules, Template->Placement, Arena->Codewords, TotalCodewords);
+  QR_STAGE_END(Placement);
+
+  QR_STAGE_BEGIN(Mask);
+  ApplyMask(Arena->Candidates[0], Arena->BaseModules, Template->MaskPlane, Height);
+  DrawRmqrFormatBits(Arena->Candidates[0], Version, Level, Width, Height);
+  QR_STAGE_END(Mask);
+
+  Arena->SymbolWidth  = Width;
+  Arena->SymbolHeight = Height;
+  Arena->SymbolMask   = 0;
+
+  if (QrCode != NULL) {
+    ZeroMem(QrCode->Modules, sizeof(QrCode->Modules));
+    QrMatrixCopy(QrCode->Modules, Arena->Candidates[0], Height);
+    QrCode->Width    = Width;
+    QrCode->Height   = Height;
+    QrCode->EccLevel = (Level == 0) ? ComputerInfoQrEccMedium : ComputerInfoQrEccHigh;
   }
 
-  Modules[(INTN)Size - 8][8] = 1;
-  FunctionModules[(INTN)Size - 8][8] = TRUE;
+  return EFI_SUCCESS;
 }
 
-STATIC
-VOID
-DrawVersionInformation(
-  IN OUT QR_MODULE_MATRIX      Modules,
-  IN OUT QR_FUNCTION_MATRIX    FunctionModules,
-  IN     UINTN                 Version,
-  IN     UINTN                 Size
+EFI_STATUS
+EncodeComputerInfoQrCode(
+  IN OUT COMPUTER_INFO_QR_ENCODER_CONTEXT *Context,
+  IN     CONST UINT8                      *Payload,
+  IN     UINTN                             PayloadLength,
+  IN     COMPUTER_INFO_QR_ECC_LEVEL        EccLevel,
+  OUT    COMPUTER_INFO_QR_CODE            *QrCode OPTIONAL
   )
 {
-  if (Version < 7) {
-    return;
+  if ((Context == NULL) || (Context->Arena == NULL) || (Payload == NULL) ||
+      ((UINTN)EccLevel > ComputerInfoQrEccAutoBoost)) {
+    return EFI_INVALID_PARAMETER;
   }
 
-  UINT32 VersionInfo = ComputeVersionInformation(Version);
+  if ((PayloadLength == 0) || (PayloadLength > COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH)) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
 
-  for (UINTN Index = 0; Index < 6; Index++) {
-    UINT8 Bit0 = (UINT8)((VersionInfo >> (Index * 3)) & 0x1);
-    UINT8 Bit1 = (UINT8)((VersionInfo >> ((Index * 3) + 1)) & 0x1);
-    UINT8 Bit2 = (UINT8)((VersionInfo >> ((Index * 3) + 2)) & 0x1);
+  QR_ENCODER_ARENA *Arena = (QR_ENCODER_ARENA *)Context->Arena;
 
-    INTN BottomRow = (INTN)Size - 11;
-    Modules[BottomRow][Index] = (INT8)Bit0;
-    FunctionModules[BottomRow][Index] = TRUE;
-    Modules[BottomRow + 1][Index] = (INT8)Bit1;
-    FunctionModules[BottomRow + 1][Index] = TRUE;
-    Modules[BottomRow + 2][Index] = (INT8)Bit2;
-    FunctionModules[BottomRow + 2][Index] = TRUE;
+  UINTN SegmentCount;
+  UINTN Level;
 
-    INTN RightColumn = (INTN)Size - 11;
-    Modules[Index][RightColumn] = (INT8)Bit0;
-    FunctionModules[Index][RightColumn] = TRUE;
-    Modules[Index][RightColumn + 1] = (INT8)Bit1;
-    FunctionModules[Index][RightColumn + 1] = TRUE;
-    Modules[Index][RightColumn + 2] = (INT8)Bit2;
-    FunctionModules[Index][RightColumn + 2] = TRUE;
+  QR_STAGE_BEGIN(Segment);
+  UINTN SelectedVersion = SelectVersionAndSegments(
+                            Payload,
+                            PayloadLength,
+                            EccLevel,
+                            Arena->SegmentTrace,
+                            Arena->Segments,
+                            &SegmentCount,
+                            &Level
+                            );
+  QR_STAGE_END(Segment);
+  if (SelectedVersion == 0) {
+    return EFI_BAD_BUFFER_SIZE;
   }
+
+  return EncodeSegmentedSymbol(Arena, Payload, SegmentCount, NULL, SelectedVersion, Level, QrCode);
 }
 
-STATIC
-INT32
-ScoreRunPenalty(
-  IN CONST INT8 *Line,
-  IN UINTN       Length
+EFI_STATUS
+EncodeComputerInfoQrRmqr(
+  IN OUT COMPUTER_INFO_QR_ENCODER_CONTEXT *Context,
+  IN     CONST UINT8                      *Payload,
+  IN     UINTN                             PayloadLength,
+  IN     COMPUTER_INFO_QR_ECC_LEVEL        EccLevel,
+  IN     UINTN                             AreaWidth,
+  IN     UINTN                             AreaHeight,
+  IN     UINTN                             QuietZone,
+  OUT    COMPUTER_INFO_QR_CODE            *QrCode OPTIONAL
   )
 {
-  INT32 Penalty = 0;
-  INTN RunLength = 1;
+  if ((Context == NULL) || (Context->Arena == NULL) || (Payload == NULL) ||
+      ((UINTN)EccLevel > ComputerInfoQrEccAutoBoost) || (QuietZone > COMPUTER_INFO_QR_MAX_QUIET_ZONE)) {
+    return EFI_INVALID_PARAMETER;
+  }
 
-  for (INTN Index = 1; Index < (INTN)Length; Index++) {
-    if (Line[Index] == Line[Index - 1]) {
-      RunLength++;
-    } else {
-      if (RunLength >= 5) {
-        INT32 Excess = (INT32)(RunLength - 5);
-        Penalty += 3 + Excess;
-      }
-      RunLength = 1;
-    }
+  if ((PayloadLength == 0) || (PayloadLength > COMPUTER_INFO_QR_RMQR_MAX_PAYLOAD_LENGTH)) {
+    return EFI_BAD_BUFFER_SIZE;
   }
 
-  if (RunLength >= 5) {
-    INT32 Excess = (INT32)(RunLength - 5);
-    Penalty += 3 + Excess;
+  QR_ENCODER_ARENA *Arena = (QR_ENCODER_ARENA *)Context->Arena;
+
+  UINTN      SegmentCount;
+  UINTN      Version;
+  UINTN      Level;
+
+  QR_STAGE_BEGIN(Segment);
+  EFI_STATUS Status = SelectRmqrVersionAndSegments(
+                        Payload,
+                        PayloadLength,
+                        EccLevel,
+                        AreaWidth,
+                        AreaHeight,
+                        QuietZone,
+                        Arena->SegmentTrace,
+                        Arena->Segments,
+                        &SegmentCount,
+                        &Version,
+                        &Level
+                        );
+  QR_STAGE_END(Segment);
+  if (EFI_ERROR(Status)) {
+    return Status;
   }
 
-  return Penalty;
+  return EncodeRmqrSymbol(Arena, Payload, SegmentCount, Version, Level, QrCode);
 }
 
-STATIC
-INT32
-EvaluatePenalty(
-  IN CONST QR_MODULE_MATRIX Modules,
-  IN UINTN                  Size
+EFI_STATUS
+EncodeComputerInfoQrStructuredAppend(
+  IN OUT COMPUTER_INFO_QR_ENCODER_CONTEXT *Context,
+  IN     CONST UINT8                      *Payload,
+  IN     UINTN                             PayloadLength,
+  IN     COMPUTER_INFO_QR_ECC_LEVEL        EccLevel,
+  OUT    COMPUTER_INFO_QR_CODE            *QrCodes OPTIONAL,
+  IN OUT UINTN                            *SymbolCount
   )
 {
-  INT32 Penalty = 0;
+  EFI_STATUS Status;
+  UINTN      ChunkEnds[COMPUTER_INFO_QR_MAX_STRUCTURED_APPEND_SYMBOLS];
+  UINTN      Version;
+  UINTN      Level;
+  UINTN      Count;
 
-  for (INTN Y = 0; Y < (INTN)Size; Y++) {
-    Penalty += ScoreRunPenalty(Modules[Y], Size);
+  if ((Context == NULL) || (Context->Arena == NULL) || (Payload == NULL) || (SymbolCount == NULL) ||
+      ((QrCodes == NULL) && (*SymbolCount != 0)) || ((UINTN)EccLevel > ComputerInfoQrEccAutoBoost)) {
+    return EFI_INVALID_PARAMETER;
   }
 
-  INT8 Column[COMPUTER_INFO_QR_MAX_SIZE];
-  for (INTN X = 0; X < (INTN)Size; X++) {
-    for (INTN Y = 0; Y < (INTN)Size; Y++) {
-      Column[Y] = Modules[Y][X];
-    }
-    Penalty += ScoreRunPenalty(Column, Size);
+  if ((PayloadLength == 0) || (PayloadLength > COMPUTER_INFO_QR_MAX_STRUCTURED_APPEND_PAYLOAD_LENGTH)) {
+    return EFI_BAD_BUFFER_SIZE;
   }
 
-  for (INTN Y = 0; Y < (INTN)Size - 1; Y++) {
-    for (INTN X = 0; X < (INTN)Size - 1; X++) {
-      INT8 Value = Modules[Y][X];
-      if ((Value == Modules[Y][X + 1]) &&
-          (Value == Modules[Y + 1][X]) &&
-          (Value == Modules[Y + 1][X + 1])) {
-        Penalty += 3;
-      }
-    }
+  Status = PlanStructuredAppend(Payload, PayloadLength, EccLevel, &Version, &Level, ChunkEnds, &Count);
+  if (EFI_ERROR(Status)) {
+    return Status;
   }
 
-  for (INTN Y = 0; Y < (INTN)Size; Y++) {
-    for (INTN X = 0; X <= (INTN)Size - 11; X++) {
-      if (Modules[Y][X] && !Modules[Y][X + 1] && Modules[Y][X + 2] && Modules[Y][X + 3] && Modules[Y][X + 4] &&
-          !Modules[Y][X + 5] && Modules[Y][X + 6] &&
-          !Modules[Y][X + 7] && !Modules[Y][X + 8] && !Modules[Y][X + 9] && !Modules[Y][X + 10]) {
-        Penalty += 40;
-      }
-      if (!Modules[Y][X] && Modules[Y][X + 1] && !Modules[Y][X + 2] && !Modules[Y][X + 3] && !Modules[Y][X + 4] &&
-          Modules[Y][X + 5] && !Modules[Y][X + 6] &&
-          Modules[Y][X + 7] && Modules[Y][X + 8] && Modules[Y][X + 9] && Modules[Y][X + 10]) {
-        Penalty += 40;
-      }
-    }
+  if (*SymbolCount < Count) {
+    *SymbolCount = Count;
+    return EFI_BUFFER_TOO_SMALL;
   }
 
-  for (INTN X = 0; X < (INTN)Size; X++) {
-    for (INTN Y = 0; Y <= (INTN)Size - 11; Y++) {
-      if (Modules[Y][X] && !Modules[Y + 1][X] && Modules[Y + 2][X] && Modules[Y + 3][X] && Modules[Y + 4][X] &&
-          !Modules[Y + 5][X] && Modules[Y + 6][X] &&
-          !Modules[Y + 7][X] && !Modules[Y + 8][X] && !Modules[Y + 9][X] && !Modules[Y + 10][X]) {
-        Penalty += 40;
-      }
-      if (!Modules[Y][X] && Modules[Y + 1][X] && !Modules[Y + 2][X] && !Modules[Y + 3][X] && !Modules[Y + 4][X] &&
-          Modules[Y + 5][X] && !Modules[Y + 6][X] &&
-          Modules[Y + 7][X] && Modules[Y + 8][X] && Modules[Y + 9][X] && Modules[Y + 10][X]) {
-        Penalty += 40;
-      }
-    }
+  QR_ENCODER_ARENA     *Arena = (QR_ENCODER_ARENA *)Context->Arena;
+  QR_STRUCTURED_APPEND Header;
+
+  Header.Count  = (UINT8)Count;
+  Header.Parity = 0;
+  for (UINTN Index = 0; Index < PayloadLength; Index++) {
+    Header.Parity ^= Payload[Index];
   }
 
-  UINTN DarkCount = 0;
-  for (INTN Y = 0; Y < (INTN)Size; Y++) {
-    for (INTN X = 0; X < (INTN)Size; X++) {
-      if (Modules[Y][X]) {
-        DarkCount++;
-      }
+  UINTN Start = 0;
+  for (UINTN Index = 0; Index < Count; Index++) {
+    UINTN SegmentCount;
+
+    ComputeOptimalSegments(
+      &Payload[Start],
+      ChunkEnds[Index] - Start,
+      Version,
+      Arena->SegmentTrace,
+      Arena->Segments,
+      &SegmentCount
+      );
+
+    Header.Index = (UINT8)Index;
+    Status = EncodeSegmentedSymbol(Arena, &Payload[Start], SegmentCount, &Header, Version, Level, &QrCodes[Index]);
+    if (EFI_ERROR(Status)) {
+      return Status;
     }
-  }
 
-  UINTN TotalModules = Size * Size;
-  INTN Percent = (INTN)((DarkCount * 100 + TotalModules / 2) / TotalModules);
-  INTN FivePercent = ABS(Percent - 50) / 5;
-  Penalty += (INT32)FivePercent * 10;
+    Start = ChunkEnds[Index];
+  }
 
-  return Penalty;
+  *SymbolCount = Count;
+  return EFI_SUCCESS;
 }
 
+//
+// Batch entries are encoded grouped by version and level, so every symbol of
+// a group copies the same cached function-pattern template and reuses the
+// Reed-Solomon product rows loaded for the group's generator. The segments
+// planned for each entry are kept and replayed when it is encoded.
+//
+#define QR_BATCH_GROUP_COUNT  \
+  ((COMPUTER_INFO_QR_MAX_VERSION - COMPUTER_INFO_QR_MIN_VERSION + 1) * QR_TABLES_LEVEL_COUNT)
+#define QR_BATCH_UNPLANNED    MAX_UINT16
+
+//
+// Makes room for Needed segments in a pool buffer that grows by doubling.
+//
+STATIC
 EFI_STATUS
-GenerateComputerInfoQrCode(
-  IN  CONST UINT8           *Payload,
-  IN  UINTN                 PayloadLength,
-  OUT COMPUTER_INFO_QR_CODE *QrCode
+ReserveBatchSegments(
+  IN OUT QR_SEGMENT **Segments,
+  IN OUT UINTN       *Capacity,
+  IN     UINTN        Needed
   )
 {
-  EFI_STATUS               Status;
-  UINT8                    *DataCodewords        = NULL;
-  UINT8                    *Codewords            = NULL;
-  UINT8                    *DataBits             = NULL;
-  QR_MODULE_MATRIX         *BaseModules          = NULL;
-  QR_FUNCTION_MATRIX       *FunctionModules      = NULL;
-  QR_MODULE_MATRIX         *BestModules          = NULL;
-  QR_MODULE_MATRIX         *MaskedModules        = NULL;
-  QR_FUNCTION_MATRIX       *MaskedFunction       = NULL;
+  if (Needed <= *Capacity) {
+    return EFI_SUCCESS;
+  }
 
-  if ((Payload == NULL) || (QrCode == NULL)) {
-    return EFI_INVALID_PARAMETER;
+  UINTN NewCapacity = MAX(*Capacity * 2, Needed);
+  QR_SEGMENT *NewSegments = AllocatePool(NewCapacity * sizeof(QR_SEGMENT));
+  if (NewSegments == NULL) {
+    return EFI_OUT_OF_RESOURCES;
   }
 
-  if ((PayloadLength == 0) || (PayloadLength > COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH)) {
-    return EFI_BAD_BUFFER_SIZE;
+  if (*Segments != NULL) {
+    CopyMem(NewSegments, *Segments, *Capacity * sizeof(QR_SEGMENT));
+    FreePool(*Segments);
   }
 
-  InitializeGaloisTables();
+  *Segments = NewSegments;
+  *Capacity = NewCapacity;
+  return EFI_SUCCESS;
+}
 
-  UINTN SelectedVersion = 0;
-  for (UINTN Version = COMPUTER_INFO_QR_MIN_VERSION; Version <= COMPUTER_INFO_QR_MAX_VERSION; Version++) {
-    UINTN Capacity = GetDataCodewordCapacity(Version);
-    if (Capacity == 0) {
-      continue;
-    }
+EFI_STATUS
+EncodeComputerInfoQrCodeBatch(
+  IN OUT COMPUTER_INFO_QR_ENCODER_CONTEXT *Context,
+  IN     CONST COMPUTER_INFO_QR_PAYLOAD   *Payloads,
+  IN     UINTN                             Count,
+  IN     COMPUTER_INFO_QR_ECC_LEVEL        EccLevel,
+  OUT    COMPUTER_INFO_QR_CODE            *QrCodes,
+  OUT    EFI_STATUS                       *Statuses OPTIONAL
+  )
+{
+  EFI_STATUS Status = EFI_SUCCESS;
+  UINTN      GroupStart[QR_BATCH_GROUP_COUNT + 1];
 
-    UINTN CharCountBits = (Version <= 9) ? 8 : 16;
-    if ((CharCountBits == 8) && (PayloadLength > 0xFF)) {
-      continue;
-    }
+  if ((Context == NULL) || (Context->Arena == NULL) ||
+      (Payloads == NULL) || (QrCodes == NULL) || (Count == 0) ||
+      ((UINTN)EccLevel > ComputerInfoQrEccAutoBoost)) {
+    return EFI_INVALID_PARAMETER;
+  }
 
-    if (PayloadLength <= Capacity) {
-      SelectedVersion = Version;
-      break;
-    }
+  //
+  // Order holds the encode order, SegmentStart[Entry] to
+  // SegmentStart[Entry + 1] the entry's planned segments, and Groups its
+  // version and level.
+  //
+  if (Count > (MAX_UINTN - sizeof(UINTN)) / ((2 * sizeof(UINTN)) + sizeof(UINT16))) {
+    return EFI_INVALID_PARAMETER;
   }
 
-  if (SelectedVersion == 0) {
-    return EFI_BAD_BUFFER_SIZE;
+  UINTN *Order = AllocatePool(Count * ((2 * sizeof(UINTN)) + sizeof(UINT16)) + sizeof(UINTN));
+  if (Order == NULL) {
+    return EFI_OUT_OF_RESOURCES;
   }
 
-  UINTN SelectedCharCountBits = (SelectedVersion <= 9) ? 8 : 16;
+  UINTN      *SegmentStart    = &Order[Count];
+  UINT16     *Groups          = (UINT16 *)&SegmentStart[Count + 1];
+  QR_SEGMENT *Segments        = NULL;
+  UINTN       SegmentCapacity = 0;
 
-  UINTN Size = 4 * SelectedVersion + 17;
-  UINTN DataCapacity = GetDataCodewordCapacity(SelectedVersion);
-  UINTN TotalCodewords = GetTotalCodewords(SelectedVersion);
-  UINTN RemainderBits = GetRemainderBits(SelectedVersion);
-  UINTN NumBlocks = GetNumErrorCorrectionBlocks(SelectedVersion);
-  UINTN EccCodewordsPerBlock = GetEccCodewordsPerBlock(SelectedVersion);
+  QR_ENCODER_ARENA *Arena = (QR_ENCODER_ARENA *)Context->Arena;
 
-  UINT8 AlignmentCenters[QR_MAX_ALIGNMENT_PATTERN_COUNT];
-  UINTN AlignmentCount;
-  GetAlignmentPatternCenters(SelectedVersion, AlignmentCenters, &AlignmentCount);
+  //
+  // Plan every entry, then counting-sort the entries by group.
+  //
+  ZeroMem(GroupStart, sizeof(GroupStart));
+  SegmentStart[0] = 0;
+  for (UINTN Index = 0; Index < Count; Index++) {
+    EFI_STATUS EntryStatus  = EFI_SUCCESS;
+    UINTN      SegmentCount = 0;
+    UINTN      Level;
+    UINTN      Version = 0;
 
-  UINTN TotalDataBits = TotalCodewords * 8 + RemainderBits;
-  DataCodewords = AllocateZeroPool(COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH);
-  if (DataCodewords == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Cleanup;
-  }
+    Groups[Index] = QR_BATCH_UNPLANNED;
+    if (Payloads[Index].Payload == NULL) {
+      EntryStatus = EFI_INVALID_PARAMETER;
+    } else if ((Payloads[Index].PayloadLength == 0) ||
+               (Payloads[Index].PayloadLength > COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH)) {
+      EntryStatus = EFI_BAD_BUFFER_SIZE;
+    } else {
+      Version = SelectVersionAndSegments(
+                  Payloads[Index].Payload,
+                  Payloads[Index].PayloadLength,
+                  EccLevel,
+                  Arena->SegmentTrace,
+                  Arena->Segments,
+                  &SegmentCount,
+                  &Level
+                  );
+      if (Version == 0) {
+        EntryStatus  = EFI_BAD_BUFFER_SIZE;
+        SegmentCount = 0;
+      } else if (EFI_ERROR(ReserveBatchSegments(&Segments, &SegmentCapacity, SegmentStart[Index] + SegmentCount))) {
+        EntryStatus  = EFI_OUT_OF_RESOURCES;
+        SegmentCount = 0;
+      } else {
+        CopyMem(&Segments[SegmentStart[Index]], Arena->Segments, SegmentCount * sizeof(QR_SEGMENT));
+        Groups[Index] = (UINT16)(((Version - COMPUTER_INFO_QR_MIN_VERSION) * QR_TABLES_LEVEL_COUNT) + Level);
+        GroupStart[Groups[Index] + 1]++;
+      }
+    }
 
-  Status = BuildDataCodewords(
-             Payload,
-             PayloadLength,
-             DataCodewords,
-             DataCapacity,
-             SelectedCharCountBits
-             );
-  if (EFI_ERROR(Status)) {
-    goto Cleanup;
-  }
+    SegmentStart[Index + 1] = SegmentStart[Index] + SegmentCount;
 
-  Codewords = AllocateZeroPool(COMPUTER_INFO_QR_MAX_TOTAL_CODEWORDS);
-  if (Codewords == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Cleanup;
-  }
+    if (Statuses != NULL) {
+      Statuses[Index] = EntryStatus;
+    }
 
-  Status = BuildCodewordSequence(
-             DataCodewords,
-             DataCapacity,
-             TotalCodewords,
-             NumBlocks,
-             EccCodewordsPerBlock,
-             Codewords
-             );
-  if (EFI_ERROR(Status)) {
-    goto Cleanup;
+    if (EFI_ERROR(EntryStatus) && !EFI_ERROR(Status)) {
+      Status = EntryStatus;
+    }
   }
 
-  DataBits = AllocateZeroPool(COMPUTER_INFO_QR_MAX_TOTAL_CODEWORDS * 8 + 7);
-  if (DataBits == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Cleanup;
+  for (UINTN Group = 0; Group < QR_BATCH_GROUP_COUNT; Group++) {
+    GroupStart[Group + 1] += GroupStart[Group];
   }
 
-  for (UINTN Bit = 0; Bit < TotalCodewords * 8; Bit++) {
-    UINT8 Byte = Codewords[Bit / 8];
-    DataBits[Bit] = (UINT8)((Byte >> (7 - (Bit % 8))) & 0x1);
+  UINTN Planned = GroupStart[QR_BATCH_GROUP_COUNT];
+  for (UINTN Index = 0; Index < Count; Index++) {
+    if (Groups[Index] != QR_BATCH_UNPLANNED) {
+      Order[GroupStart[Groups[Index]]++] = Index;
+    }
   }
-  for (UINTN Bit = TotalCodewords * 8; Bit < TotalDataBits; Bit++) {
-    DataBits[Bit] = 0;
+
+  //
+  // Encoding in group order. The first failure in payload order is returned;
+  // later entries are still encoded.
+  //
+  UINTN FirstFailure = MAX_UINTN;
+  for (UINTN Index = 0; Index < Count; Index++) {
+    if (Groups[Index] == QR_BATCH_UNPLANNED) {
+      FirstFailure = Index;
+      break;
+    }
   }
 
-  BaseModules = AllocateZeroPool(sizeof(*BaseModules));
-  if (BaseModules == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Cleanup;
+  for (UINTN Position = 0; Position < Planned; Position++) {
+    UINTN Entry        = Order[Position];
+    UINTN Version      = (Groups[Entry] / QR_TABLES_LEVEL_COUNT) + COMPUTER_INFO_QR_MIN_VERSION;
+    UINTN Level        = Groups[Entry] % QR_TABLES_LEVEL_COUNT;
+    UINTN SegmentCount = SegmentStart[Entry + 1] - SegmentStart[Entry];
+
+    CopyMem(Arena->Segments, &Segments[SegmentStart[Entry]], SegmentCount * sizeof(QR_SEGMENT));
+
+    EFI_STATUS EntryStatus = EncodeSegmentedSymbol(
+                               Arena,
+                               Payloads[Entry].Payload,
+                               SegmentCount,
+                               NULL,
+                               Version,
+                               Level,
+                               &QrCodes[Entry]
+                               );
+    if (Statuses != NULL) {
+      Statuses[Entry] = EntryStatus;
+    }
+
+    if (EFI_ERROR(EntryStatus) && (Entry < FirstFailure)) {
+      FirstFailure = Entry;
+      Status = EntryStatus;
+    }
   }
 
-  FunctionModules = AllocateZeroPool(sizeof(*FunctionModules));
-  if (FunctionModules == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Cleanup;
+  if (Segments != NULL) {
+    FreePool(Segments);
   }
 
-  DrawFinderPattern(*BaseModules, *FunctionModules, 0, 0, Size);
-  DrawFinderPattern(*BaseModules, *FunctionModules, (INTN)Size - 7, 0, Size);
-  DrawFinderPattern(*BaseModules, *FunctionModules, 0, (INTN)Size - 7, Size);
+  FreePool(Order);
+  return Status;
+}
 
-  DrawTimingPatterns(*BaseModules, *FunctionModules, Size);
+EFI_STATUS
+GenerateComputerInfoQrCodeBatch(
+  IN  CONST COMPUTER_INFO_QR_PAYLOAD *Payloads,
+  IN  UINTN                           Count,
+  IN  COMPUTER_INFO_QR_ECC_LEVEL      EccLevel,
+  OUT COMPUTER_INFO_QR_CODE          *QrCodes,
+  OUT EFI_STATUS                     *Statuses OPTIONAL
+  )
+{
+  COMPUTER_INFO_QR_ENCODER_CONTEXT Context;
 
-  DrawAlignmentPatterns(*BaseModules, *FunctionModules, AlignmentCenters, AlignmentCount, Size);
+  if ((Payloads == NULL) || (QrCodes == NULL) || (Count == 0) ||
+      ((UINTN)EccLevel > ComputerInfoQrEccAutoBoost)) {
+    return EFI_INVALID_PARAMETER;
+  }
 
-  ReserveFormatInfo(*FunctionModules, Size);
-  DrawVersionInformation(*BaseModules, *FunctionModules, SelectedVersion, Size);
+  EFI_STATUS Status = InitializeComputerInfoQrEncoder(&Context);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
 
-  (*BaseModules)[(INTN)Size - 8][8] = 1;
-  (*FunctionModules)[(INTN)Size - 8][8] = TRUE;
+  Status = EncodeComputerInfoQrCodeBatch(&Context, Payloads, Count, EccLevel, QrCodes, Statuses);
+  FreeComputerInfoQrEncoder(&Context);
+  return Status;
+}
 
-  PlaceDataBits(*BaseModules, *FunctionModules, DataBits, TotalDataBits, Size);
+EFI_STATUS
+GenerateComputerInfoQrCode(
+  IN  CONST UINT8           *Payload,
+  IN  UINTN                 PayloadLength,
+  OUT COMPUTER_INFO_QR_CODE *QrCode
+  )
+{
+  EFI_STATUS                       Status;
+  COMPUTER_INFO_QR_ENCODER_CONTEXT Context;
 
-  INT32 BestPenalty = MAX_INT32;
+  if ((Payload == NULL) || (QrCode == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
 
-  BestModules = AllocateZeroPool(sizeof(*BestModules));
-  if (BestModules == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Cleanup;
+  if ((PayloadLength == 0) || (PayloadLength > COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH)) {
+    return EFI_BAD_BUFFER_SIZE;
   }
 
-  MaskedModules = AllocateZeroPool(sizeof(*MaskedModules));
-  if (MaskedModules == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Cleanup;
+  Status = InitializeComputerInfoQrEncoder(&Context);
+  if (EFI_ERROR(Status)) {
+    return Status;
   }
 
-  MaskedFunction = AllocateZeroPool(sizeof(*MaskedFunction));
-  if (MaskedFunction == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Cleanup;
+  Status = EncodeComputerInfoQrCode(&Context, Payload, PayloadLength, ComputerInfoQrEccLow, QrCode);
+  FreeComputerInfoQrEncoder(&Context);
+  return Status;
+}
+
+BOOLEAN
+GetComputerInfoQrModule(
+  IN CONST COMPUTER_INFO_QR_CODE *QrCode,
+  IN UINTN                        X,
+  IN UINTN                        Y
+  )
+{
+  if ((QrCode == NULL) || (X >= QrCode->Width) || (Y >= QrCode->Height)) {
+    return FALSE;
   }
 
-  for (UINTN Mask = 0; Mask < 8; Mask++) {
-    CopyMem(*MaskedModules, *BaseModules, sizeof(*BaseModules));
-    CopyMem(*MaskedFunction, *FunctionModules, sizeof(*FunctionModules));
+  return QrMatrixGet(QrCode->Modules, X, Y);
+}
 
-    ApplyMask(*MaskedModules, *MaskedFunction, Mask, Size);
-    DrawFormatBits(*MaskedModules, *MaskedFunction, Mask, Size);
+STATIC
+VOID
+StartRowIterator(
+  IN  CONST UINT64                   Modules[][QR_ROW_WORDS],
+  IN  UINTN                          Width,
+  IN  UINTN                          Height,
+  IN  UINTN                          QuietZone,
+  OUT COMPUTER_INFO_QR_ROW_ITERATOR *Iterator
+  )
+{
+  Iterator->Modules      = Modules;
+  Iterator->Width        = Width;
+  Iterator->Height       = Height;
+  Iterator->QuietZone    = QuietZone;
+  Iterator->PaddedWidth  = Width + (2 * QuietZone);
+  Iterator->PaddedHeight = Height + (2 * QuietZone);
+  Iterator->NextRow      = 0;
+}
 
-    INT32 Penalty = EvaluatePenalty(*MaskedModules, Size);
-    if (Penalty < BestPenalty) {
-      BestPenalty = Penalty;
-      CopyMem(*BestModules, *MaskedModules, sizeof(*BestModules));
-    }
+EFI_STATUS
+InitializeComputerInfoQrRowIterator(
+  IN  CONST COMPUTER_INFO_QR_ENCODER_CONTEXT *Context,
+  IN  UINTN                                   QuietZone,
+  OUT COMPUTER_INFO_QR_ROW_ITERATOR          *Iterator
+  )
+{
+  if ((Context == NULL) || (Context->Arena == NULL) || (Iterator == NULL) ||
+      (QuietZone > COMPUTER_INFO_QR_MAX_QUIET_ZONE)) {
+    return EFI_INVALID_PARAMETER;
   }
 
-  for (UINTN Y = 0; Y < Size; Y++) {
-    CopyMem(QrCode->Modules[Y], (*BestModules)[Y], Size * sizeof(UINT8));
+  CONST QR_ENCODER_ARENA *Arena = (CONST QR_ENCODER_ARENA *)Context->Arena;
+  if (Arena->SymbolWidth == 0) {
+    return EFI_NOT_READY;
   }
 
-  QrCode->Size = Size;
-  Status = EFI_SUCCESS;
+  StartRowIterator(Arena->Candidates[Arena->SymbolMask], Arena->SymbolWidth, Arena->SymbolHeight, QuietZone, Iterator);
+  return EFI_SUCCESS;
+}
 
-Cleanup:
-  if (MaskedFunction != NULL) {
-    FreePool(MaskedFunction);
-  }
-  if (MaskedModules != NULL) {
-    FreePool(MaskedModules);
-  }
-  if (BestModules != NULL) {
-    FreePool(BestModules);
-  }
-  if (FunctionModules != NULL) {
-    FreePool(FunctionModules);
-  }
-  if (BaseModules != NULL) {
-    FreePool(BaseModules);
+EFI_STATUS
+InitializeComputerInfoQrCodeRowIterator(
+  IN  CONST COMPUTER_INFO_QR_CODE   *QrCode,
+  IN  UINTN                          QuietZone,
+  OUT COMPUTER_INFO_QR_ROW_ITERATOR *Iterator
+  )
+{
+  if ((QrCode == NULL) || (Iterator == NULL) ||
+      (QrCode->Width == 0) || (QrCode->Width > COMPUTER_INFO_QR_MAX_SIZE) ||
+      (QrCode->Height == 0) || (QrCode->Height > COMPUTER_INFO_QR_MAX_SIZE) ||
+      (QuietZone > COMPUTER_INFO_QR_MAX_QUIET_ZONE)) {
+    return EFI_INVALID_PARAMETER;
   }
-  if (DataBits != NULL) {
-    FreePool(DataBits);
+
+  StartRowIterator(QrCode->Modules, QrCode->Width, QrCode->Height, QuietZone, Iterator);
+  return EFI_SUCCESS;
+}
+
+//
+// A symbol row is shifted left by QuietZone bits across word boundaries;
+// the bits above its last module are clear, so the right quiet zone comes
+// for free.
+//
+BOOLEAN
+GetNextComputerInfoQrRow(
+  IN OUT COMPUTER_INFO_QR_ROW_ITERATOR *Iterator,
+  OUT    UINT64                         Row[COMPUTER_INFO_QR_PADDED_ROW_WORDS]
+  )
+{
+  if ((Iterator == NULL) || (Row == NULL) || (Iterator->NextRow >= Iterator->PaddedHeight)) {
+    return FALSE;
   }
-  if (Codewords != NULL) {
-    FreePool(Codewords);
+
+  UINTN Y = Iterator->NextRow++;
+
+  ZeroMem(Row, COMPUTER_INFO_QR_PADDED_ROW_WORDS * sizeof(UINT64));
+  if ((Y < Iterator->QuietZone) || (Y >= Iterator->QuietZone + Iterator->Height)) {
+    return TRUE;
   }
-  if (DataCodewords != NULL) {
-    FreePool(DataCodewords);
+
+  CONST UINT64 *Source = Iterator->Modules[Y - Iterator->QuietZone];
+  UINTN        Shift   = Iterator->QuietZone;
+
+  for (UINTN Word = 0; Word < COMPUTER_INFO_QR_PADDED_ROW_WORDS; Word++) {
+    UINT64 Low  = (Word < QR_ROW_WORDS) ? Source[Word] : 0;
+    UINT64 High = ((Word > 0) && (Word <= QR_ROW_WORDS) && (Shift != 0)) ? (Source[Word - 1] >> (64 - Shift)) : 0;
+    Row[Word] = (Low << Shift) | High;
   }
 
-  return Status;
+  return TRUE;
 }
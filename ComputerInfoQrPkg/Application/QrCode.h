@@ -3,21 +3,203 @@
 
 #include <Uefi.h>
 
-#define COMPUTER_INFO_QR_MIN_VERSION                  7
-#define COMPUTER_INFO_QR_MAX_VERSION                  23
+#define COMPUTER_INFO_QR_MIN_VERSION                  1
+#define COMPUTER_INFO_QR_MAX_VERSION                  40
 #define COMPUTER_INFO_QR_MAX_SIZE                     (4 * COMPUTER_INFO_QR_MAX_VERSION + 17)
-#define COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH           1094
-#define COMPUTER_INFO_QR_MAX_ERROR_CORRECTION_BLOCKS  9
+#define COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH           2953
+#define COMPUTER_INFO_QR_MAX_DATA_CODEWORDS           2956
+#define COMPUTER_INFO_QR_MAX_ERROR_CORRECTION_BLOCKS  81
 #define COMPUTER_INFO_QR_MAX_ECC_CODEWORDS_PER_BLOCK  30
-#define COMPUTER_INFO_QR_MAX_TOTAL_CODEWORDS          \
-  (COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH + \
-   (COMPUTER_INFO_QR_MAX_ERROR_CORRECTION_BLOCKS * COMPUTER_INFO_QR_MAX_ECC_CODEWORDS_PER_BLOCK))
+#define COMPUTER_INFO_QR_MAX_TOTAL_CODEWORDS          3706
+#define COMPUTER_INFO_QR_ROW_WORDS                    ((COMPUTER_INFO_QR_MAX_SIZE + 63) / 64)
+#define COMPUTER_INFO_QR_MAX_QUIET_ZONE               4
+#define COMPUTER_INFO_QR_MAX_PADDED_SIZE              (COMPUTER_INFO_QR_MAX_SIZE + (2 * COMPUTER_INFO_QR_MAX_QUIET_ZONE))
+#define COMPUTER_INFO_QR_PADDED_ROW_WORDS             ((COMPUTER_INFO_QR_MAX_PADDED_SIZE + 63) / 64)
 
+//
+// rMQR (rectangular Micro QR) symbols are at most 17 modules high and 139
+// wide, so they fit the same module storage as QR symbols.
+//
+#define COMPUTER_INFO_QR_RMQR_VERSION_COUNT       32
+#define COMPUTER_INFO_QR_RMQR_MAX_WIDTH           139
+#define COMPUTER_INFO_QR_RMQR_MAX_HEIGHT          17
+#define COMPUTER_INFO_QR_RMQR_MAX_PAYLOAD_LENGTH  150
+
+#define COMPUTER_INFO_QR_MAX_STRUCTURED_APPEND_SYMBOLS  16
+#define COMPUTER_INFO_QR_MAX_STRUCTURED_APPEND_PAYLOAD_LENGTH \
+  (COMPUTER_INFO_QR_MAX_STRUCTURED_APPEND_SYMBOLS * COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH)
+
+//
+// Error correction levels, in order of increasing redundancy. AutoBoost picks
+// the smallest version that holds the payload at level Low and then raises the
+// level as far as that version still holds it.
+//
+typedef enum {
+  ComputerInfoQrEccLow,
+  ComputerInfoQrEccMedium,
+  ComputerInfoQrEccQuartile,
+  ComputerInfoQrEccHigh,
+  ComputerInfoQrEccAutoBoost
+} COMPUTER_INFO_QR_ECC_LEVEL;
+
+//
+// Modules are stored one bit per module. Module (X, Y) lives in bit (X % 64)
+// of Modules[Y][X / 64]; a set bit is a dark module. QR symbols are square;
+// rMQR symbols are wider than high. EccLevel is the level the symbol was
+// encoded at, never ComputerInfoQrEccAutoBoost.
+//
 typedef struct {
-  UINTN Size;
-  UINT8 Modules[COMPUTER_INFO_QR_MAX_SIZE][COMPUTER_INFO_QR_MAX_SIZE];
+  UINTN                      Width;
+  UINTN                      Height;
+  COMPUTER_INFO_QR_ECC_LEVEL EccLevel;
+  UINT64                     Modules[COMPUTER_INFO_QR_MAX_SIZE][COMPUTER_INFO_QR_ROW_WORDS];
 } COMPUTER_INFO_QR_CODE;
 
+//
+// Mask search backends. The encoder scores all eight mask candidates through
+// the installed backend: Dispatch must call Worker exactly once for every
+// candidate index below CandidateCount and return once all calls finished.
+// Calls for different indexes may run concurrently. If Dispatch fails the
+// encoder falls back to scoring the candidates serially.
+//
+typedef
+VOID
+(EFIAPI *COMPUTER_INFO_QR_MASK_WORKER)(
+  IN VOID  *WorkerContext,
+  IN UINTN  CandidateIndex
+  );
+
+typedef
+EFI_STATUS
+(EFIAPI *COMPUTER_INFO_QR_MASK_DISPATCH)(
+  IN VOID                          *BackendContext,
+  IN COMPUTER_INFO_QR_MASK_WORKER   Worker,
+  IN VOID                          *WorkerContext,
+  IN UINTN                          CandidateCount
+  );
+
+typedef struct {
+  COMPUTER_INFO_QR_MASK_DISPATCH  Dispatch;
+  VOID                           *Context;
+} COMPUTER_INFO_QR_MASK_SEARCH_BACKEND;
+
+//
+// Reusable encoder state. InitializeComputerInfoQrEncoder allocates a single
+// workspace sized for the largest supported version; EncodeComputerInfoQrCode
+// reuses it without further pool allocations once the version templates it
+// needs are cached. The workspace also keeps the last symbol encoded through
+// it, which a row iterator can read in place. A context must not be used by
+// two encodes at once; separate contexts may encode concurrently, since all
+// mutable encode state lives in the context and the shared version templates
+// never change once published. FreeComputerInfoQrCaches must not run while
+// any encode is in progress.
+//
+typedef struct {
+  VOID *Arena;
+} COMPUTER_INFO_QR_ENCODER_CONTEXT;
+
+EFI_STATUS
+InitializeComputerInfoQrEncoder(
+  OUT COMPUTER_INFO_QR_ENCODER_CONTEXT *Context
+  );
+
+//
+// Encodes one symbol. QrCode may be NULL when the symbol is only read back
+// through a row iterator on Context.
+//
+EFI_STATUS
+EncodeComputerInfoQrCode(
+  IN OUT COMPUTER_INFO_QR_ENCODER_CONTEXT *Context,
+  IN     CONST UINT8                      *Payload,
+  IN     UINTN                             PayloadLength,
+  IN     COMPUTER_INFO_QR_ECC_LEVEL        EccLevel,
+  OUT    COMPUTER_INFO_QR_CODE            *QrCode OPTIONAL
+  );
+
+//
+// Encodes one rMQR symbol. rMQR only defines levels Medium and High, so Low
+// is encoded at Medium and Quartile at High; AutoBoost encodes at Medium and
+// raises it to High when the chosen version still holds the payload. Of the
+// versions that hold the payload, the one whose modules come out largest in
+// an AreaWidth by AreaHeight pixel area, with QuietZone light modules on
+// every side, is chosen. Ties, and every version when the area is empty, go
+// to the symbol with the fewest modules.
+//
+EFI_STATUS
+EncodeComputerInfoQrRmqr(
+  IN OUT COMPUTER_INFO_QR_ENCODER_CONTEXT *Context,
+  IN     CONST UINT8                      *Payload,
+  IN     UINTN                             PayloadLength,
+  IN     COMPUTER_INFO_QR_ECC_LEVEL        EccLevel,
+  IN     UINTN                             AreaWidth,
+  IN     UINTN                             AreaHeight,
+  IN     UINTN                             QuietZone,
+  OUT    COMPUTER_INFO_QR_CODE            *QrCode OPTIONAL
+  );
+
+//
+// Splits a payload too large for one symbol across up to
+// COMPUTER_INFO_QR_MAX_STRUCTURED_APPEND_SYMBOLS Structured Append symbols.
+// The split uses as few symbols as possible, all of the smallest version
+// that holds the payload in that many, with the data balanced between them.
+// On input SymbolCount is the number of entries in QrCodes; on output it is
+// the number of symbols written, or needed when EFI_BUFFER_TOO_SMALL is
+// returned.
+//
+EFI_STATUS
+EncodeComputerInfoQrStructuredAppend(
+  IN OUT COMPUTER_INFO_QR_ENCODER_CONTEXT *Context,
+  IN     CONST UINT8                      *Payload,
+  IN     UINTN                             PayloadLength,
+  IN     COMPUTER_INFO_QR_ECC_LEVEL        EccLevel,
+  OUT    COMPUTER_INFO_QR_CODE            *QrCodes OPTIONAL,
+  IN OUT UINTN                            *SymbolCount
+  );
+
+VOID
+FreeComputerInfoQrEncoder(
+  IN OUT COMPUTER_INFO_QR_ENCODER_CONTEXT *Context
+  );
+
+//
+// Encodes Count independent payloads into QrCodes[0..Count-1], one symbol
+// each, through Context. Entries are encoded grouped by version and level so
+// a group shares its function-pattern template and Reed-Solomon generator.
+// Statuses, when given, receives the result for every entry; the return
+// value is the first failure in payload order, and entries after a failure
+// are still encoded. Afterwards Context holds the last symbol encoded, which
+// need not be the last entry.
+//
+typedef struct {
+  CONST UINT8 *Payload;
+  UINTN        PayloadLength;
+} COMPUTER_INFO_QR_PAYLOAD;
+
+EFI_STATUS
+EncodeComputerInfoQrCodeBatch(
+  IN OUT COMPUTER_INFO_QR_ENCODER_CONTEXT *Context,
+  IN     CONST COMPUTER_INFO_QR_PAYLOAD   *Payloads,
+  IN     UINTN                             Count,
+  IN     COMPUTER_INFO_QR_ECC_LEVEL        EccLevel,
+  OUT    COMPUTER_INFO_QR_CODE            *QrCodes,
+  OUT    EFI_STATUS                       *Statuses OPTIONAL
+  );
+
+//
+// EncodeComputerInfoQrCodeBatch through a temporary context.
+//
+EFI_STATUS
+GenerateComputerInfoQrCodeBatch(
+  IN  CONST COMPUTER_INFO_QR_PAYLOAD *Payloads,
+  IN  UINTN                           Count,
+  IN  COMPUTER_INFO_QR_ECC_LEVEL      EccLevel,
+  OUT COMPUTER_INFO_QR_CODE          *QrCodes,
+  OUT EFI_STATUS                     *Statuses OPTIONAL
+  );
+
+//
+// One-shot encode at ComputerInfoQrEccLow through a temporary context.
+//
 EFI_STATUS
 GenerateComputerInfoQrCode(
   IN  CONST UINT8              *Payload,
@@ -25,4 +207,88 @@ GenerateComputerInfoQrCode(
   OUT COMPUTER_INFO_QR_CODE    *QrCode
   );
 
+BOOLEAN
+GetComputerInfoQrModule(
+  IN CONST COMPUTER_INFO_QR_CODE *QrCode,
+  IN UINTN                        X,
+  IN UINTN                        Y
+  );
+
+//
+// Streams a symbol one row at a time with QuietZone light modules added on
+// every side, so a renderer needs one row of storage instead of a matrix.
+// Rows use the module layout above over PaddedWidth columns and come top to
+// bottom, PaddedHeight of them, quiet zone rows included. An iterator started on a context reads
+// the symbol inside it and is invalidated by the next encode through that
+// context; one started on a COMPUTER_INFO_QR_CODE reads that copy.
+//
+typedef struct {
+  CONST UINT64 (*Modules)[COMPUTER_INFO_QR_ROW_WORDS];
+  UINTN        Width;
+  UINTN        Height;
+  UINTN        QuietZone;
+  UINTN        PaddedWidth;
+  UINTN        PaddedHeight;
+  UINTN        NextRow;
+} COMPUTER_INFO_QR_ROW_ITERATOR;
+
+//
+// Returns EFI_NOT_READY when Context holds no finished symbol: nothing was
+// encoded through it yet, or an encode failed after it started building one.
+//
+EFI_STATUS
+InitializeComputerInfoQrRowIterator(
+  IN  CONST COMPUTER_INFO_QR_ENCODER_CONTEXT *Context,
+  IN  UINTN                                   QuietZone,
+  OUT COMPUTER_INFO_QR_ROW_ITERATOR          *Iterator
+  );
+
+EFI_STATUS
+InitializeComputerInfoQrCodeRowIterator(
+  IN  CONST COMPUTER_INFO_QR_CODE   *QrCode,
+  IN  UINTN                          QuietZone,
+  OUT COMPUTER_INFO_QR_ROW_ITERATOR *Iterator
+  );
+
+//
+// Writes the next row to Row and returns TRUE, or returns FALSE once all
+// PaddedHeight rows were produced.
+//
+BOOLEAN
+GetNextComputerInfoQrRow(
+  IN OUT COMPUTER_INFO_QR_ROW_ITERATOR *Iterator,
+  OUT    UINT64                         Row[COMPUTER_INFO_QR_PADDED_ROW_WORDS]
+  );
+
+//
+// Installs a mask search backend. Passing NULL restores the built-in serial
+// backend. Call it on the BSP; it also picks the vector routines the mask
+// workers use, and a backend other than the serial one never gets AVX2.
+//
+VOID
+SetComputerInfoQrMaskSearchBackend(
+  IN CONST COMPUTER_INFO_QR_MASK_SEARCH_BACKEND *Backend OPTIONAL
+  );
+
+//
+// Draws the function pattern templates for every supported QR and rMQR
+// version up front, so later encodes only copy them. Without this call each
+// template is built the first time its version is encoded. All of them
+// together take about 1.9 MB of pool, nearly all of it for the QR versions,
+// held until FreeComputerInfoQrCaches.
+//
+EFI_STATUS
+PrecomputeComputerInfoQrTemplates(
+  VOID
+  );
+
+//
+// Releases the per-version templates the encoder keeps. Encoding again
+// afterwards simply rebuilds them.
+//
+VOID
+FreeComputerInfoQrCaches(
+  VOID
+  );
+
 #endif
@@ -0,0 +1,369 @@
+//
+// Generated by ComputerInfoQrPkg/Scripts/GenerateQrTables.py. Do not edit.
+//
+
+#ifndef COMPUTER_INFO_QR_QRCODE_TABLES_H_
+#define COMPUTER_INFO_QR_QRCODE_TABLES_H_
+
+#define QR_TABLES_MIN_VERSION  1
+#define QR_TABLES_MAX_VERSION  40
+#define QR_TABLES_LEVEL_COUNT  4
+#define QR_GENERATOR_COUNT     18
+
+#define RMQR_TABLES_VERSION_COUNT  32
+#define RMQR_TABLES_LEVEL_COUNT    2
+
+//
+// Block layout per error correction level (L, M, Q, H) and version.
+//
+STATIC CONST UINT8 mEccCodewordsPerBlock[4][41] = {
+  {  // L
+     0,  7, 10, 15, 20, 26, 18, 20, 24, 30, 18, 20, 24, 26, 30, 22, 24, 28, 30, 28, 28,
+    28, 28, 30, 30, 26, 28, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30
+  },
+  {  // M
+     0, 10, 16, 26, 18, 24, 16, 18, 22, 22, 26, 30, 22, 22, 24, 24, 28, 28, 26, 26, 26,
+    26, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28
+  },
+  {  // Q
+     0, 13, 22, 18, 26, 18, 24, 18, 22, 20, 24, 28, 26, 24, 20, 30, 24, 28, 28, 26, 30,
+    28, 30, 30, 30, 30, 28, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30
+  },
+  {  // H
+     0, 17, 28, 22, 16, 22, 28, 26, 26, 24, 28, 24, 28, 22, 24, 24, 30, 28, 28, 26, 28,
+    30, 24, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30
+  },
+};
+
+STATIC CONST UINT8 mNumErrorCorrectionBlocks[4][41] = {
+  {  // L
+     0,  1,  1,  1,  1,  1,  2,  2,  2,  2,  4,  4,  4,  4,  4,  6,  6,  6,  6,  7,  8,
+     8,  9,  9, 10, 12, 12, 12, 13, 14, 15, 16, 17, 18, 19, 19, 20, 21, 22, 24, 25
+  },
+  {  // M
+     0,  1,  1,  1,  2,  2,  4,  4,  4,  5,  5,  5,  8,  9,  9, 10, 10, 11, 13, 14, 16,
+    17, 17, 18, 20, 21, 23, 25, 26, 28, 29, 31, 33, 35, 37, 38, 40, 43, 45, 47, 49
+  },
+  {  // Q
+     0,  1,  1,  2,  2,  4,  4,  6,  6,  8,  8,  8, 10, 12, 16, 12, 17, 16, 18, 21, 20,
+    23, 23, 25, 27, 29, 34, 34, 35, 38, 40, 43, 45, 48, 51, 53, 56, 59, 62, 65, 68
+  },
+  {  // H
+     0,  1,  1,  2,  4,  4,  4,  5,  6,  8,  8, 11, 11, 16, 16, 18, 16, 19, 21, 25, 25,
+    25, 34, 30, 32, 35, 37, 40, 42, 45, 48, 51, 54, 57, 60, 63, 66, 70, 74, 77, 81
+  },
+};
+
+//
+// Data codewords per level and version. Each row increases with the
+// version, so the smallest version that holds a payload can be found by
+// binary search.
+//
+STATIC CONST UINT16 mDataCodewordCapacity[4][41] = {
+  {  // L
+       0,   19,   34,   55,   80,  108,  136,  156,  194,  232,  274,  324,
+     370,  428,  461,  523,  589,  647,  721,  795,  861,  932, 1006, 1094,
+    1174, 1276, 1370, 1468, 1531, 1631, 1735, 1843, 1955, 2071, 2191, 2306,
+    2434, 2566, 2702, 2812, 2956
+  },
+  {  // M
+       0,   16,   28,   44,   64,   86,  108,  124,  154,  182,  216,  254,
+     290,  334,  365,  415,  453,  507,  563,  627,  669,  714,  782,  860,
+     914, 1000, 1062, 1128, 1193, 1267, 1373, 1455, 1541, 1631, 1725, 1812,
+    1914, 1992, 2102, 2216, 2334
+  },
+  {  // Q
+       0,   13,   22,   34,   48,   62,   76,   88,  110,  132,  154,  180,
+     206,  244,  261,  295,  325,  367,  397,  445,  485,  512,  568,  614,
+     664,  718,  754,  808,  871,  911,  985, 1033, 1115, 1171, 1231, 1286,
+    1354, 1426, 1502, 1582, 1666
+  },
+  {  // H
+       0,    9,   16,   26,   36,   46,   60,   66,   86,  100,  122,  140,
+     158,  180,  197,  223,  253,  283,  313,  341,  385,  406,  442,  464,
+     514,  538,  596,  628,  661,  701,  745,  793,  845,  901,  961,  986,
+    1054, 1096, 1142, 1222, 1276
+  },
+};
+
+//
+// rMQR versions in version indicator order: symbol height and width, total
+// codewords and character count bits for numeric, alphanumeric and byte.
+//
+typedef struct {
+  UINT8 Height;
+  UINT8 Width;
+  UINT8 TotalCodewords;
+  UINT8 CharCountBits[3];
+} RMQR_VERSION_INFO;
+
+STATIC CONST RMQR_VERSION_INFO mRmqrVersions[RMQR_TABLES_VERSION_COUNT] = {
+  {  7,  43,  13, { 4, 3, 3 } },  // R7x43
+  {  7,  59,  21, { 5, 5, 4 } },  // R7x59
+  {  7,  77,  32, { 6, 5, 5 } },  // R7x77
+  {  7,  99,  44, { 7, 6, 5 } },  // R7x99
+  {  7, 139,  68, { 7, 6, 6 } },  // R7x139
+  {  9,  43,  21, { 5, 5, 4 } },  // R9x43
+  {  9,  59,  33, { 6, 5, 5 } },  // R9x59
+  {  9,  77,  49, { 7, 6, 5 } },  // R9x77
+  {  9,  99,  66, { 7, 6, 6 } },  // R9x99
+  {  9, 139,  99, { 8, 7, 6 } },  // R9x139
+  { 11,  27,  15, { 4, 4, 3 } },  // R11x27
+  { 11,  43,  31, { 6, 5, 5 } },  // R11x43
+  { 11,  59,  47, { 7, 6, 5 } },  // R11x59
+  { 11,  77,  67, { 7, 6, 6 } },  // R11x77
+  { 11,  99,  89, { 8, 7, 6 } },  // R11x99
+  { 11, 139, 132, { 8, 7, 7 } },  // R11x139
+  { 13,  27,  21, { 5, 5, 4 } },  // R13x27
+  { 13,  43,  41, { 6, 6, 5 } },  // R13x43
+  { 13,  59,  60, { 7, 6, 6 } },  // R13x59
+  { 13,  77,  85, { 7, 7, 6 } },  // R13x77
+  { 13,  99, 113, { 8, 7, 7 } },  // R13x99
+  { 13, 139, 166, { 8, 8, 7 } },  // R13x139
+  { 15,  43,  51, { 7, 6, 6 } },  // R15x43
+  { 15,  59,  74, { 7, 7, 6 } },  // R15x59
+  { 15,  77, 103, { 8, 7, 7 } },  // R15x77
+  { 15,  99, 136, { 8, 7, 7 } },  // R15x99
+  { 15, 139, 199, { 9, 8, 7 } },  // R15x139
+  { 17,  43,  61, { 7, 6, 6 } },  // R17x43
+  { 17,  59,  88, { 8, 7, 6 } },  // R17x59
+  { 17,  77, 122, { 8, 7, 7 } },  // R17x77
+  { 17,  99, 160, { 8, 8, 7 } },  // R17x99
+  { 17, 139, 232, { 9, 8, 8 } },  // R17x139
+};
+
+//
+// rMQR block layout and data codewords per level (M, H) and version
+// indicator.
+//
+STATIC CONST UINT8 mRmqrEccCodewordsPerBlock[2][32] = {
+  {  // M
+     7,  9, 12, 16, 12,  9, 12,  9, 12, 12,  8, 12, 16, 12, 16, 16,
+     9, 14, 11, 16, 20, 20, 18, 13, 18, 24, 24, 11, 16, 22, 20, 20
+  },
+  {  // H
+    10, 14, 22, 15, 22, 14, 22, 16, 22, 22, 10, 20, 16, 22, 30, 30,
+    14, 28, 20, 28, 26, 28, 18, 24, 24, 22, 26, 20, 30, 28, 26, 26
+  },
+};
+
+STATIC CONST UINT8 mRmqrNumErrorCorrectionBlocks[2][32] = {
+  {  // M
+     1,  1,  1,  1,  2,  1,  1,  2,  2,  3,  1,  1,  1,  2,  2,  3,
+     1,  1,  2,  2,  2,  3,  1,  2,  2,  2,  3,  2,  2,  2,  3,  4
+  },
+  {  // H
+     1,  1,  1,  2,  2,  1,  1,  2,  2,  3,  1,  1,  2,  2,  2,  3,
+     1,  1,  2,  2,  3,  4,  2,  2,  3,  4,  5,  2,  2,  3,  4,  6
+  },
+};
+
+STATIC CONST UINT8 mRmqrDataCodewordCapacity[2][32] = {
+  {  // M
+      6,  12,  20,  28,  44,  12,  21,  31,  42,  63,   7,  19,  31,  43,  57,  84,
+     12,  27,  38,  53,  73, 106,  33,  48,  67,  88, 127,  39,  56,  78, 100, 152
+  },
+  {  // H
+      3,   7,  10,  14,  24,   7,  11,  17,  22,  33,   5,  11,  15,  23,  29,  42,
+      7,  13,  20,  29,  35,  54,  15,  26,  31,  48,  69,  21,  28,  38,  56,  76
+  },
+};
+
+//
+// GF(256) over x^8 + x^4 + x^3 + x^2 + 1. The exponent table is doubled so
+// the sum of two logarithms can index it without a modulo.
+//
+STATIC CONST UINT8 mGaloisExpTable[512] = {
+  0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1D, 0x3A, 0x74, 0xE8, 0xCD, 0x87, 0x13, 0x26,
+  0x4C, 0x98, 0x2D, 0x5A, 0xB4, 0x75, 0xEA, 0xC9, 0x8F, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xC0,
+  0x9D, 0x27, 0x4E, 0x9C, 0x25, 0x4A, 0x94, 0x35, 0x6A, 0xD4, 0xB5, 0x77, 0xEE, 0xC1, 0x9F, 0x23,
+  0x46, 0x8C, 0x05, 0x0A, 0x14, 0x28, 0x50, 0xA0, 0x5D, 0xBA, 0x69, 0xD2, 0xB9, 0x6F, 0xDE, 0xA1,
+  0x5F, 0xBE, 0x61, 0xC2, 0x99, 0x2F, 0x5E, 0xBC, 0x65, 0xCA, 0x89, 0x0F, 0x1E, 0x3C, 0x78, 0xF0,
+  0xFD, 0xE7, 0xD3, 0xBB, 0x6B, 0xD6, 0xB1, 0x7F, 0xFE, 0xE1, 0xDF, 0xA3, 0x5B, 0xB6, 0x71, 0xE2,
+  0xD9, 0xAF, 0x43, 0x86, 0x11, 0x22, 0x44, 0x88, 0x0D, 0x1A, 0x34, 0x68, 0xD0, 0xBD, 0x67, 0xCE,
+  0x81, 0x1F, 0x3E, 0x7C, 0xF8, 0xED, 0xC7, 0x93, 0x3B, 0x76, 0xEC, 0xC5, 0x97, 0x33, 0x66, 0xCC,
+  0x85, 0x17, 0x2E, 0x5C, 0xB8, 0x6D, 0xDA, 0xA9, 0x4F, 0x9E, 0x21, 0x42, 0x84, 0x15, 0x2A, 0x54,
+  0xA8, 0x4D, 0x9A, 0x29, 0x52, 0xA4, 0x55, 0xAA, 0x49, 0x92, 0x39, 0x72, 0xE4, 0xD5, 0xB7, 0x73,
+  0xE6, 0xD1, 0xBF, 0x63, 0xC6, 0x91, 0x3F, 0x7E, 0xFC, 0xE5, 0xD7, 0xB3, 0x7B, 0xF6, 0xF1, 0xFF,
+  0xE3, 0xDB, 0xAB, 0x4B, 0x96, 0x31, 0x62, 0xC4, 0x95, 0x37, 0x6E, 0xDC, 0xA5, 0x57, 0xAE, 0x41,
+  0x82, 0x19, 0x32, 0x64, 0xC8, 0x8D, 0x07, 0x0E, 0x1C, 0x38, 0x70, 0xE0, 0xDD, 0xA7, 0x53, 0xA6,
+  0x51, 0xA2, 0x59, 0xB2, 0x79, 0xF2, 0xF9, 0xEF, 0xC3, 0x9B, 0x2B, 0x56, 0xAC, 0x45, 0x8A, 0x09,
+  0x12, 0x24, 0x48, 0x90, 0x3D, 0x7A, 0xF4, 0xF5, 0xF7, 0xF3, 0xFB, 0xEB, 0xCB, 0x8B, 0x0B, 0x16,
+  0x2C, 0x58, 0xB0, 0x7D, 0xFA, 0xE9, 0xCF, 0x83, 0x1B, 0x36, 0x6C, 0xD8, 0xAD, 0x47, 0x8E, 0x01,
+  0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1D, 0x3A, 0x74, 0xE8, 0xCD, 0x87, 0x13, 0x26, 0x4C,
+  0x98, 0x2D, 0x5A, 0xB4, 0x75, 0xEA, 0xC9, 0x8F, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xC0, 0x9D,
+  0x27, 0x4E, 0x9C, 0x25, 0x4A, 0x94, 0x35, 0x6A, 0xD4, 0xB5, 0x77, 0xEE, 0xC1, 0x9F, 0x23, 0x46,
+  0x8C, 0x05, 0x0A, 0x14, 0x28, 0x50, 0xA0, 0x5D, 0xBA, 0x69, 0xD2, 0xB9, 0x6F, 0xDE, 0xA1, 0x5F,
+  0xBE, 0x61, 0xC2, 0x99, 0x2F, 0x5E, 0xBC, 0x65, 0xCA, 0x89, 0x0F, 0x1E, 0x3C, 0x78, 0xF0, 0xFD,
+  0xE7, 0xD3, 0xBB, 0x6B, 0xD6, 0xB1, 0x7F, 0xFE, 0xE1, 0xDF, 0xA3, 0x5B, 0xB6, 0x71, 0xE2, 0xD9,
+  0xAF, 0x43, 0x86, 0x11, 0x22, 0x44, 0x88, 0x0D, 0x1A, 0x34, 0x68, 0xD0, 0xBD, 0x67, 0xCE, 0x81,
+  0x1F, 0x3E, 0x7C, 0xF8, 0xED, 0xC7, 0x93, 0x3B, 0x76, 0xEC, 0xC5, 0x97, 0x33, 0x66, 0xCC, 0x85,
+  0x17, 0x2E, 0x5C, 0xB8, 0x6D, 0xDA, 0xA9, 0x4F, 0x9E, 0x21, 0x42, 0x84, 0x15, 0x2A, 0x54, 0xA8,
+  0x4D, 0x9A, 0x29, 0x52, 0xA4, 0x55, 0xAA, 0x49, 0x92, 0x39, 0x72, 0xE4, 0xD5, 0xB7, 0x73, 0xE6,
+  0xD1, 0xBF, 0x63, 0xC6, 0x91, 0x3F, 0x7E, 0xFC, 0xE5, 0xD7, 0xB3, 0x7B, 0xF6, 0xF1, 0xFF, 0xE3,
+  0xDB, 0xAB, 0x4B, 0x96, 0x31, 0x62, 0xC4, 0x95, 0x37, 0x6E, 0xDC, 0xA5, 0x57, 0xAE, 0x41, 0x82,
+  0x19, 0x32, 0x64, 0xC8, 0x8D, 0x07, 0x0E, 0x1C, 0x38, 0x70, 0xE0, 0xDD, 0xA7, 0x53, 0xA6, 0x51,
+  0xA2, 0x59, 0xB2, 0x79, 0xF2, 0xF9, 0xEF, 0xC3, 0x9B, 0x2B, 0x56, 0xAC, 0x45, 0x8A, 0x09, 0x12,
+  0x24, 0x48, 0x90, 0x3D, 0x7A, 0xF4, 0xF5, 0xF7, 0xF3, 0xFB, 0xEB, 0xCB, 0x8B, 0x0B, 0x16, 0x2C,
+  0x58, 0xB0, 0x7D, 0xFA, 0xE9, 0xCF, 0x83, 0x1B, 0x36, 0x6C, 0xD8, 0xAD, 0x47, 0x8E, 0x01, 0x02
+};
+
+STATIC CONST UINT8 mGaloisLogTable[256] = {
+  0x00, 0x00, 0x01, 0x19, 0x02, 0x32, 0x1A, 0xC6, 0x03, 0xDF, 0x33, 0xEE, 0x1B, 0x68, 0xC7, 0x4B,
+  0x04, 0x64, 0xE0, 0x0E, 0x34, 0x8D, 0xEF, 0x81, 0x1C, 0xC1, 0x69, 0xF8, 0xC8, 0x08, 0x4C, 0x71,
+  0x05, 0x8A, 0x65, 0x2F, 0xE1, 0x24, 0x0F, 0x21, 0x35, 0x93, 0x8E, 0xDA, 0xF0, 0x12, 0x82, 0x45,
+  0x1D, 0xB5, 0xC2, 0x7D, 0x6A, 0x27, 0xF9, 0xB9, 0xC9, 0x9A, 0x09, 0x78, 0x4D, 0xE4, 0x72, 0xA6,
+  0x06, 0xBF, 0x8B, 0x62, 0x66, 0xDD, 0x30, 0xFD, 0xE2, 0x98, 0x25, 0xB3, 0x10, 0x91, 0x22, 0x88,
+  0x36, 0xD0, 0x94, 0xCE, 0x8F, 0x96, 0xDB, 0xBD, 0xF1, 0xD2, 0x13, 0x5C, 0x83, 0x38, 0x46, 0x40,
+  0x1E, 0x42, 0xB6, 0xA3, 0xC3, 0x48, 0x7E, 0x6E, 0x6B, 0x3A, 0x28, 0x54, 0xFA, 0x85, 0xBA, 0x3D,
+  0xCA, 0x5E, 0x9B, 0x9F, 0x0A, 0x15, 0x79, 0x2B, 0x4E, 0xD4, 0xE5, 0xAC, 0x73, 0xF3, 0xA7, 0x57,
+  0x07, 0x70, 0xC0, 0xF7, 0x8C, 0x80, 0x63, 0x0D, 0x67, 0x4A, 0xDE, 0xED, 0x31, 0xC5, 0xFE, 0x18,
+  0xE3, 0xA5, 0x99, 0x77, 0x26, 0xB8, 0xB4, 0x7C, 0x11, 0x44, 0x92, 0xD9, 0x23, 0x20, 0x89, 0x2E,
+  0x37, 0x3F, 0xD1, 0x5B, 0x95, 0xBC, 0xCF, 0xCD, 0x90, 0x87, 0x97, 0xB2, 0xDC, 0xFC, 0xBE, 0x61,
+  0xF2, 0x56, 0xD3, 0xAB, 0x14, 0x2A, 0x5D, 0x9E, 0x84, 0x3C, 0x39, 0x53, 0x47, 0x6D, 0x41, 0xA2,
+  0x1F, 0x2D, 0x43, 0xD8, 0xB7, 0x7B, 0xA4, 0x76, 0xC4, 0x17, 0x49, 0xEC, 0x7F, 0x0C, 0x6F, 0xF6,
+  0x6C, 0xA1, 0x3B, 0x52, 0x29, 0x9D, 0x55, 0xAA, 0xFB, 0x60, 0x86, 0xB1, 0xBB, 0xCC, 0x3E, 0x5A,
+  0xCB, 0x59, 0x5F, 0xB0, 0x9C, 0xA9, 0xA0, 0x51, 0x0B, 0xF5, 0x16, 0xEB, 0x7A, 0x75, 0x2C, 0xD7,
+  0x4F, 0xAE, 0xD5, 0xE9, 0xE6, 0xE7, 0xAD, 0xE8, 0x74, 0xD6, 0xF4, 0xEA, 0xA8, 0x50, 0x58, 0xAF
+};
+
+//
+// Reed-Solomon generator polynomials in log form, without the implicit
+// leading coefficient. Coefficients[I] is log(g[I + 1]) for the monic
+// generator of the given degree, highest power first.
+//
+typedef struct {
+  UINT8 Degree;
+  UINT8 Coefficients[30];
+} QR_GENERATOR_POLYNOMIAL;
+
+STATIC CONST QR_GENERATOR_POLYNOMIAL mGeneratorPolynomials[QR_GENERATOR_COUNT] = {
+  {
+    7,
+    {
+    0x57, 0xE5, 0x92, 0x95, 0xEE, 0x66, 0x15
+    }
+  },
+  {
+    8,
+    {
+    0xAF, 0xEE, 0xD0, 0xF9, 0xD7, 0xFC, 0xC4, 0x1C
+    }
+  },
+  {
+    9,
+    {
+    0x5F, 0xF6, 0x89, 0xE7, 0xEB, 0x95, 0x0B, 0x7B, 0x24
+    }
+  },
+  {
+    10,
+    {
+    0xFB, 0x43, 0x2E, 0x3D, 0x76, 0x46, 0x40, 0x5E, 0x20, 0x2D
+    }
+  },
+  {
+    11,
+    {
+    0xDC, 0xC0, 0x5B, 0xC2, 0xAC, 0xB1, 0xD1, 0x74, 0xE3, 0x0A, 0x37
+    }
+  },
+  {
+    12,
+    {
+    0x66, 0x2B, 0x62, 0x79, 0xBB, 0x71, 0xC6, 0x8F, 0x83, 0x57, 0x9D, 0x42
+    }
+  },
+  {
+    13,
+    {
+    0x4A, 0x98, 0xB0, 0x64, 0x56, 0x64, 0x6A, 0x68, 0x82, 0xDA, 0xCE, 0x8C, 0x4E
+    }
+  },
+  {
+    14,
+    {
+    0xC7, 0xF9, 0x9B, 0x30, 0xBE, 0x7C, 0xDA, 0x89, 0xD8, 0x57, 0xCF, 0x3B, 0x16, 0x5B
+    }
+  },
+  {
+    15,
+    {
+    0x08, 0xB7, 0x3D, 0x5B, 0xCA, 0x25, 0x33, 0x3A, 0x3A, 0xED, 0x8C, 0x7C, 0x05, 0x63, 0x69
+    }
+  },
+  {
+    16,
+    {
+    0x78, 0x68, 0x6B, 0x6D, 0x66, 0xA1, 0x4C, 0x03, 0x5B, 0xBF, 0x93, 0xA9, 0xB6, 0xC2, 0xE1,
+    0x78
+    }
+  },
+  {
+    17,
+    {
+    0x2B, 0x8B, 0xCE, 0x4E, 0x2B, 0xEF, 0x7B, 0xCE, 0xD6, 0x93, 0x18, 0x63, 0x96, 0x27, 0xF3,
+    0xA3, 0x88
+    }
+  },
+  {
+    18,
+    {
+    0xD7, 0xEA, 0x9E, 0x5E, 0xB8, 0x61, 0x76, 0xAA, 0x4F, 0xBB, 0x98, 0x94, 0xFC, 0xB3, 0x05,
+    0x62, 0x60, 0x99
+    }
+  },
+  {
+    20,
+    {
+    0x11, 0x3C, 0x4F, 0x32, 0x3D, 0xA3, 0x1A, 0xBB, 0xCA, 0xB4, 0xDD, 0xE1, 0x53, 0xEF, 0x9C,
+    0xA4, 0xD4, 0xD4, 0xBC, 0xBE
+    }
+  },
+  {
+    22,
+    {
+    0xD2, 0xAB, 0xF7, 0xF2, 0x5D, 0xE6, 0x0E, 0x6D, 0xDD, 0x35, 0xC8, 0x4A, 0x08, 0xAC, 0x62,
+    0x50, 0xDB, 0x86, 0xA0, 0x69, 0xA5, 0xE7
+    }
+  },
+  {
+    24,
+    {
+    0xE5, 0x79, 0x87, 0x30, 0xD3, 0x75, 0xFB, 0x7E, 0x9F, 0xB4, 0xA9, 0x98, 0xC0, 0xE2, 0xE4,
+    0xDA, 0x6F, 0x00, 0x75, 0xE8, 0x57, 0x60, 0xE3, 0x15
+    }
+  },
+  {
+    26,
+    {
+    0xAD, 0x7D, 0x9E, 0x02, 0x67, 0xB6, 0x76, 0x11, 0x91, 0xC9, 0x6F, 0x1C, 0xA5, 0x35, 0xA1,
+    0x15, 0xF5, 0x8E, 0x0D, 0x66, 0x30, 0xE3, 0x99, 0x91, 0xDA, 0x46
+    }
+  },
+  {
+    28,
+    {
+    0xA8, 0xDF, 0xC8, 0x68, 0xE0, 0xEA, 0x6C, 0xB4, 0x6E, 0xBE, 0xC3, 0x93, 0xCD, 0x1B, 0xE8,
+    0xC9, 0x15, 0x2B, 0xF5, 0x57, 0x2A, 0xC3, 0xD4, 0x77, 0xF2, 0x25, 0x09, 0x7B
+    }
+  },
+  {
+    30,
+    {
+    0x29, 0xAD, 0x91, 0x98, 0xD8, 0x1F, 0xB3, 0xB6, 0x32, 0x30, 0x6E, 0x56, 0xEF, 0x60, 0xDE,
+    0x7D, 0x2A, 0xAD, 0xE2, 0xC1, 0xE0, 0x82, 0x9C, 0x25, 0xFB, 0xD8, 0xEE, 0x28, 0xC0, 0xB4
+    }
+  },
+};
+
+//
+// Maps an ECC block size to its entry in mGeneratorPolynomials; 0xFF marks
+// sizes no supported version uses.
+//
+STATIC CONST UINT8 mGeneratorIndexByDegree[31] = {
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+  0x09, 0x0A, 0x0B, 0xFF, 0x0C, 0xFF, 0x0D, 0xFF, 0x0E, 0xFF, 0x0F, 0xFF, 0x10, 0xFF, 0x11
+};
+
+#endif
@@ -0,0 +1,122 @@
+#include "QrMaskSearchMp.h"
+#include "QrCode.h"
+
+#include <Library/SynchronizationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+#include <Protocol/MpService.h>
+
+typedef struct {
+  COMPUTER_INFO_QR_MASK_WORKER  Worker;
+  VOID                         *WorkerContext;
+  UINT32                        CandidateCount;
+  volatile UINT32               NextCandidate;
+} QR_MP_MASK_JOB;
+
+//
+// Runs on every enabled AP. Each processor keeps claiming the next unscored
+// candidate until none are left, so the work balances itself regardless of
+// how many APs are available.
+//
+STATIC
+VOID
+EFIAPI
+QrMpMaskProcedure(
+  IN OUT VOID *Buffer
+  )
+{
+  QR_MP_MASK_JOB *Job = (QR_MP_MASK_JOB *)Buffer;
+
+  while (TRUE) {
+    UINT32 Candidate = InterlockedIncrement(&Job->NextCandidate) - 1;
+    if (Candidate >= Job->CandidateCount) {
+      return;
+    }
+
+    Job->Worker(Job->WorkerContext, Candidate);
+  }
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+DispatchMaskCandidatesMp(
+  IN VOID                          *BackendContext,
+  IN COMPUTER_INFO_QR_MASK_WORKER   Worker,
+  IN VOID                          *WorkerContext,
+  IN UINTN                          CandidateCount
+  )
+{
+  EFI_MP_SERVICES_PROTOCOL *MpServices = (EFI_MP_SERVICES_PROTOCOL *)BackendContext;
+  QR_MP_MASK_JOB            Job;
+  EFI_STATUS                Status;
+
+  if ((MpServices == NULL) || (Worker == NULL) || (CandidateCount > MAX_UINT32)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Job.Worker         = Worker;
+  Job.WorkerContext  = WorkerContext;
+  Job.CandidateCount = (UINT32)CandidateCount;
+  Job.NextCandidate  = 0;
+
+  Status = MpServices->StartupAllAPs(
+                         MpServices,
+                         QrMpMaskProcedure,
+                         FALSE,
+                         NULL,
+                         0,
+                         &Job,
+                         NULL
+                         );
+  if (EFI_ERROR(Status) && (Status != EFI_NOT_STARTED)) {
+    return Status;
+  }
+
+  //
+  // Drain whatever the APs did not claim. This also covers the case where
+  // every AP was disabled after the backend was installed.
+  //
+  QrMpMaskProcedure(&Job);
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+InstallComputerInfoQrMpMaskSearch(
+  VOID
+  )
+{
+  EFI_STATUS                           Status;
+  EFI_MP_SERVICES_PROTOCOL             *MpServices = NULL;
+  UINTN                                ProcessorCount;
+  UINTN                                EnabledProcessorCount;
+  COMPUTER_INFO_QR_MASK_SEARCH_BACKEND Backend;
+
+  if (gBS == NULL) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = gBS->LocateProtocol(
+                  &gEfiMpServiceProtocolGuid,
+                  NULL,
+                  (VOID **)&MpServices
+                  );
+  if (EFI_ERROR(Status) || (MpServices == NULL)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = MpServices->GetNumberOfProcessors(
+                         MpServices,
+                         &ProcessorCount,
+                         &EnabledProcessorCount
+                         );
+  if (EFI_ERROR(Status) || (EnabledProcessorCount < 2)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Backend.Dispatch = DispatchMaskCandidatesMp;
+  Backend.Context  = MpServices;
+  SetComputerInfoQrMaskSearchBackend(&Backend);
+
+  return EFI_SUCCESS;
+}
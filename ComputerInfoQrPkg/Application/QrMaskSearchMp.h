@@ -0,0 +1,17 @@
+#ifndef COMPUTER_INFO_QR_MASK_SEARCH_MP_H_
+#define COMPUTER_INFO_QR_MASK_SEARCH_MP_H_
+
+#include <Uefi.h>
+
+//
+// Installs a mask search backend that spreads the QR mask candidates across
+// the application processors reported by EFI_MP_SERVICES_PROTOCOL. Returns
+// EFI_UNSUPPORTED when the protocol is missing or no AP is enabled, in which
+// case the encoder keeps using its serial backend.
+//
+EFI_STATUS
+InstallComputerInfoQrMpMaskSearch(
+  VOID
+  );
+
+#endif
@@ -0,0 +1,313 @@
+#!/usr/bin/env python3
+"""Generates the constant tables used by the QR code encoder.
+
+The encoder needs the block layout of every version and error correction
+level of both QR and rMQR, the GF(256) exponent and logarithm tables and a
+Reed-Solomon generator polynomial for every error correction block size it
+uses. All of it is fixed data, so it is emitted as STATIC CONST arrays instead of being built
+at runtime.
+
+The script is run as the PREBUILD step of ComputerInfoQrPkg.dsc and can be run
+by hand after editing the tables below. The output is only rewritten when its
+contents change.
+"""
+
+import argparse
+import os
+import sys
+
+GF_SIZE = 256
+GF_GENERATOR_POLYNOMIAL = 0x11D
+
+MIN_VERSION = 1
+MAX_VERSION = 40
+
+# Error correction levels in order of increasing redundancy. The encoder uses
+# the same order for COMPUTER_INFO_QR_ECC_LEVEL, so a level indexes the tables
+# directly.
+ECC_LEVELS = ['L', 'M', 'Q', 'H']
+
+# Indexed by level and version (index 0 of each row is unused).
+ECC_CODEWORDS_PER_BLOCK = {
+    'L': [0, 7, 10, 15, 20, 26, 18, 20, 24, 30, 18, 20, 24, 26, 30, 22, 24, 28, 30, 28, 28,
+          28, 28, 30, 30, 26, 28, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30],
+    'M': [0, 10, 16, 26, 18, 24, 16, 18, 22, 22, 26, 30, 22, 22, 24, 24, 28, 28, 26, 26, 26,
+          26, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28],
+    'Q': [0, 13, 22, 18, 26, 18, 24, 18, 22, 20, 24, 28, 26, 24, 20, 30, 24, 28, 28, 26, 30,
+          28, 30, 30, 30, 30, 28, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30],
+    'H': [0, 17, 28, 22, 16, 22, 28, 26, 26, 24, 28, 24, 28, 22, 24, 24, 30, 28, 28, 26, 28,
+          30, 24, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30],
+}
+
+NUM_ERROR_CORRECTION_BLOCKS = {
+    'L': [0, 1, 1, 1, 1, 1, 2, 2, 2, 2, 4, 4, 4, 4, 4, 6, 6, 6, 6, 7, 8,
+          8, 9, 9, 10, 12, 12, 12, 13, 14, 15, 16, 17, 18, 19, 19, 20, 21, 22, 24, 25],
+    'M': [0, 1, 1, 1, 2, 2, 4, 4, 4, 5, 5, 5, 8, 9, 9, 10, 10, 11, 13, 14, 16,
+          17, 17, 18, 20, 21, 23, 25, 26, 28, 29, 31, 33, 35, 37, 38, 40, 43, 45, 47, 49],
+    'Q': [0, 1, 1, 2, 2, 4, 4, 6, 6, 8, 8, 8, 10, 12, 16, 12, 17, 16, 18, 21, 20,
+          23, 23, 25, 27, 29, 34, 34, 35, 38, 40, 43, 45, 48, 51, 53, 56, 59, 62, 65, 68],
+    'H': [0, 1, 1, 2, 4, 4, 4, 5, 6, 8, 8, 11, 11, 16, 16, 18, 16, 19, 21, 25, 25,
+          25, 34, 30, 32, 35, 37, 40, 42, 45, 48, 51, 54, 57, 60, 63, 66, 70, 74, 77, 81],
+}
+
+# rMQR (ISO/IEC 23941) versions in version indicator order, as
+# (height, width, total codewords, character count bits for numeric,
+# alphanumeric and byte).
+RMQR_VERSIONS = [
+    (7, 43, 13, (4, 3, 3)), (7, 59, 21, (5, 5, 4)), (7, 77, 32, (6, 5, 5)),
+    (7, 99, 44, (7, 6, 5)), (7, 139, 68, (7, 6, 6)),
+    (9, 43, 21, (5, 5, 4)), (9, 59, 33, (6, 5, 5)), (9, 77, 49, (7, 6, 5)),
+    (9, 99, 66, (7, 6, 6)), (9, 139, 99, (8, 7, 6)),
+    (11, 27, 15, (4, 4, 3)), (11, 43, 31, (6, 5, 5)), (11, 59, 47, (7, 6, 5)),
+    (11, 77, 67, (7, 6, 6)), (11, 99, 89, (8, 7, 6)), (11, 139, 132, (8, 7, 7)),
+    (13, 27, 21, (5, 5, 4)), (13, 43, 41, (6, 6, 5)), (13, 59, 60, (7, 6, 6)),
+    (13, 77, 85, (7, 7, 6)), (13, 99, 113, (8, 7, 7)), (13, 139, 166, (8, 8, 7)),
+    (15, 43, 51, (7, 6, 6)), (15, 59, 74, (7, 7, 6)), (15, 77, 103, (8, 7, 7)),
+    (15, 99, 136, (8, 7, 7)), (15, 139, 199, (9, 8, 7)),
+    (17, 43, 61, (7, 6, 6)), (17, 59, 88, (8, 7, 6)), (17, 77, 122, (8, 7, 7)),
+    (17, 99, 160, (8, 8, 7)), (17, 139, 232, (9, 8, 8)),
+]
+
+# rMQR only defines levels M and H. Indexed by version indicator.
+RMQR_ECC_LEVELS = ['M', 'H']
+
+RMQR_ECC_CODEWORDS_PER_BLOCK = {
+    'M': [7, 9, 12, 16, 12, 9, 12, 9, 12, 12, 8, 12, 16, 12, 16, 16,
+          9, 14, 11, 16, 20, 20, 18, 13, 18, 24, 24, 11, 16, 22, 20, 20],
+    'H': [10, 14, 22, 15, 22, 14, 22, 16, 22, 22, 10, 20, 16, 22, 30, 30,
+          14, 28, 20, 28, 26, 28, 18, 24, 24, 22, 26, 20, 30, 28, 26, 26],
+}
+
+RMQR_NUM_ERROR_CORRECTION_BLOCKS = {
+    'M': [1, 1, 1, 1, 2, 1, 1, 2, 2, 3, 1, 1, 1, 2, 2, 3,
+          1, 1, 2, 2, 2, 3, 1, 2, 2, 2, 3, 2, 2, 2, 3, 4],
+    'H': [1, 1, 1, 2, 2, 1, 1, 2, 2, 3, 1, 1, 2, 2, 2, 3,
+          1, 1, 2, 2, 3, 4, 2, 2, 3, 4, 5, 2, 2, 3, 4, 6],
+}
+
+DEFAULT_OUTPUT = os.path.join(
+    os.path.dirname(os.path.abspath(__file__)), '..', 'Application', 'QrCodeTables.h'
+)
+
+
+def build_galois_tables():
+    exp_table = [0] * (GF_SIZE * 2)
+    log_table = [0] * GF_SIZE
+    value = 1
+    for index in range(GF_SIZE - 1):
+        exp_table[index] = value
+        log_table[value] = index
+        value <<= 1
+        if value & GF_SIZE:
+            value ^= GF_GENERATOR_POLYNOMIAL
+    for index in range(GF_SIZE - 1, GF_SIZE * 2):
+        exp_table[index] = exp_table[index - (GF_SIZE - 1)]
+    return exp_table, log_table
+
+
+def multiply(exp_table, log_table, a, b):
+    if a == 0 or b == 0:
+        return 0
+    return exp_table[log_table[a] + log_table[b]]
+
+
+def generator_polynomial(exp_table, log_table, degree):
+    """Returns the monic generator (x - a^0)...(x - a^(degree-1)), highest
+    coefficient first."""
+    result = [1] + [0] * degree
+    for d in range(degree):
+        factor = exp_table[d]
+        for index in range(d + 1, 0, -1):
+            result[index] ^= multiply(exp_table, log_table, result[index - 1], factor)
+    return result
+
+
+def num_raw_data_modules(version):
+    """Modules left for codewords and remainder bits once every function
+    pattern of the version is drawn."""
+    result = (16 * version + 128) * version + 64
+    if version >= 2:
+        num_align = version // 7 + 2
+        result -= (25 * num_align - 10) * num_align - 55
+        if version >= 7:
+            result -= 36
+    return result
+
+
+def data_codeword_capacity(level, version):
+    total = num_raw_data_modules(version) // 8
+    return total - ECC_CODEWORDS_PER_BLOCK[level][version] * NUM_ERROR_CORRECTION_BLOCKS[level][version]
+
+
+def rmqr_data_codeword_capacity(level, index):
+    total = RMQR_VERSIONS[index][2]
+    blocks = RMQR_NUM_ERROR_CORRECTION_BLOCKS[level][index]
+    ecc = RMQR_ECC_CODEWORDS_PER_BLOCK[level][index]
+    if total // blocks <= ecc:
+        raise ValueError('rMQR version %d level %s has no data codewords' % (index, level))
+    return total - ecc * blocks
+
+
+def render_level_table(out, c_type, name, rows, per_line, width, levels=ECC_LEVELS):
+    out.append('STATIC CONST %s %s[%d][%d] = {' % (c_type, name, len(levels), len(rows[levels[0]])))
+    for level in levels:
+        values = rows[level]
+        out.append('  {  // %s' % level)
+        out.append(',\n'.join('    ' + ', '.join(('%d' % v).rjust(width) for v in values[start:start + per_line])
+                              for start in range(0, len(values), per_line)))
+        out.append('  },')
+    out.append('};')
+
+
+def format_rows(values, per_line, width):
+    lines = []
+    for start in range(0, len(values), per_line):
+        chunk = values[start:start + per_line]
+        lines.append('  ' + ', '.join(('0x%02X' % v).rjust(width) for v in chunk))
+    return ',\n'.join(lines)
+
+
+def render(exp_table, log_table):
+    degrees = sorted({ECC_CODEWORDS_PER_BLOCK[level][v]
+                      for level in ECC_LEVELS
+                      for v in range(MIN_VERSION, MAX_VERSION + 1)} |
+                     {RMQR_ECC_CODEWORDS_PER_BLOCK[level][index]
+                      for level in RMQR_ECC_LEVELS
+                      for index in range(len(RMQR_VERSIONS))})
+    max_degree = max(degrees)
+
+    out = []
+    out.append('//')
+    out.append('// Generated by ComputerInfoQrPkg/Scripts/GenerateQrTables.py. Do not edit.')
+    out.append('//')
+    out.append('')
+    out.append('#ifndef COMPUTER_INFO_QR_QRCODE_TABLES_H_')
+    out.append('#define COMPUTER_INFO_QR_QRCODE_TABLES_H_')
+    out.append('')
+    out.append('#define QR_TABLES_MIN_VERSION  %d' % MIN_VERSION)
+    out.append('#define QR_TABLES_MAX_VERSION  %d' % MAX_VERSION)
+    out.append('#define QR_TABLES_LEVEL_COUNT  %d' % len(ECC_LEVELS))
+    out.append('#define QR_GENERATOR_COUNT     %d' % len(degrees))
+    out.append('')
+    out.append('#define RMQR_TABLES_VERSION_COUNT  %d' % len(RMQR_VERSIONS))
+    out.append('#define RMQR_TABLES_LEVEL_COUNT    %d' % len(RMQR_ECC_LEVELS))
+    out.append('')
+    out.append('//')
+    out.append('// Block layout per error correction level (%s) and version.' % ', '.join(ECC_LEVELS))
+    out.append('//')
+    render_level_table(out, 'UINT8', 'mEccCodewordsPerBlock', ECC_CODEWORDS_PER_BLOCK, 21, 2)
+    out.append('')
+    render_level_table(out, 'UINT8', 'mNumErrorCorrectionBlocks', NUM_ERROR_CORRECTION_BLOCKS, 21, 2)
+    out.append('')
+    capacities = {level: [0] + [data_codeword_capacity(level, v) for v in range(1, MAX_VERSION + 1)]
+                  for level in ECC_LEVELS}
+    out.append('//')
+    out.append('// Data codewords per level and version. Each row increases with the')
+    out.append('// version, so the smallest version that holds a payload can be found by')
+    out.append('// binary search.')
+    out.append('//')
+    render_level_table(out, 'UINT16', 'mDataCodewordCapacity', capacities, 12, 4)
+    out.append('')
+    out.append('//')
+    out.append('// rMQR versions in version indicator order: symbol height and width, total')
+    out.append('// codewords and character count bits for numeric, alphanumeric and byte.')
+    out.append('//')
+    out.append('typedef struct {')
+    out.append('  UINT8 Height;')
+    out.append('  UINT8 Width;')
+    out.append('  UINT8 TotalCodewords;')
+    out.append('  UINT8 CharCountBits[3];')
+    out.append('} RMQR_VERSION_INFO;')
+    out.append('')
+    out.append('STATIC CONST RMQR_VERSION_INFO mRmqrVersions[RMQR_TABLES_VERSION_COUNT] = {')
+    for height, width, total, bits in RMQR_VERSIONS:
+        out.append('  { %2d, %3d, %3d, { %d, %d, %d } },  // R%dx%d' % ((height, width, total) + bits + (height, width)))
+    out.append('};')
+    out.append('')
+    out.append('//')
+    out.append('// rMQR block layout and data codewords per level (%s) and version' % ', '.join(RMQR_ECC_LEVELS))
+    out.append('// indicator.')
+    out.append('//')
+    render_level_table(out, 'UINT8', 'mRmqrEccCodewordsPerBlock', RMQR_ECC_CODEWORDS_PER_BLOCK, 16, 2, RMQR_ECC_LEVELS)
+    out.append('')
+    render_level_table(out, 'UINT8', 'mRmqrNumErrorCorrectionBlocks', RMQR_NUM_ERROR_CORRECTION_BLOCKS, 16, 2, RMQR_ECC_LEVELS)
+    out.append('')
+    rmqr_capacities = {level: [rmqr_data_codeword_capacity(level, index) for index in range(len(RMQR_VERSIONS))]
+                       for level in RMQR_ECC_LEVELS}
+    render_level_table(out, 'UINT8', 'mRmqrDataCodewordCapacity', rmqr_capacities, 16, 3, RMQR_ECC_LEVELS)
+    out.append('')
+    out.append('//')
+    out.append('// GF(256) over x^8 + x^4 + x^3 + x^2 + 1. The exponent table is doubled so')
+    out.append('// the sum of two logarithms can index it without a modulo.')
+    out.append('//')
+    out.append('STATIC CONST UINT8 mGaloisExpTable[%d] = {' % len(exp_table))
+    out.append(format_rows(exp_table, 16, 4))
+    out.append('};')
+    out.append('')
+    out.append('STATIC CONST UINT8 mGaloisLogTable[%d] = {' % len(log_table))
+    out.append(format_rows(log_table, 16, 4))
+    out.append('};')
+    out.append('')
+    out.append('//')
+    out.append('// Reed-Solomon generator polynomials in log form, without the implicit')
+    out.append('// leading coefficient. Coefficients[I] is log(g[I + 1]) for the monic')
+    out.append('// generator of the given degree, highest power first.')
+    out.append('//')
+    out.append('typedef struct {')
+    out.append('  UINT8 Degree;')
+    out.append('  UINT8 Coefficients[%d];' % max_degree)
+    out.append('} QR_GENERATOR_POLYNOMIAL;')
+    out.append('')
+    out.append('STATIC CONST QR_GENERATOR_POLYNOMIAL mGeneratorPolynomials[QR_GENERATOR_COUNT] = {')
+    for degree in degrees:
+        poly = generator_polynomial(exp_table, log_table, degree)
+        coefficients = poly[1:]
+        if any(c == 0 for c in coefficients):
+            raise ValueError('generator of degree %d has a zero coefficient' % degree)
+        logs = [log_table[c] for c in coefficients]
+        out.append('  {')
+        out.append('    %d,' % degree)
+        out.append('    {')
+        out.append('  ' + format_rows(logs, 15, 4).replace('\n  ', '\n    '))
+        out.append('    }')
+        out.append('  },')
+    out.append('};')
+    out.append('')
+    index_by_degree = [0xFF] * (max_degree + 1)
+    for index, degree in enumerate(degrees):
+        index_by_degree[degree] = index
+    out.append('//')
+    out.append('// Maps an ECC block size to its entry in mGeneratorPolynomials; 0xFF marks')
+    out.append('// sizes no supported version uses.')
+    out.append('//')
+    out.append('STATIC CONST UINT8 mGeneratorIndexByDegree[%d] = {' % len(index_by_degree))
+    out.append(format_rows(index_by_degree, 16, 4))
+    out.append('};')
+    out.append('')
+    out.append('#endif')
+    out.append('')
+    return '\n'.join(out)
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--output', default=DEFAULT_OUTPUT, help='header to write')
+    # The EDK II build passes its own command line to PREBUILD scripts.
+    args, _ = parser.parse_known_args(argv)
+
+    exp_table, log_table = build_galois_tables()
+    content = render(exp_table, log_table)
+
+    output = os.path.normpath(args.output)
+    if os.path.isfile(output):
+        with open(output, 'r', newline='') as existing:
+            if existing.read() == content:
+                return 0
+
+    with open(output, 'w', newline='\n') as handle:
+        handle.write(content)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,334 @@
+//
+// Host throughput benchmark for the QR encoder.
+//
+//   gcc -std=gnu11 -O2 -Wall -I stubs bench_qr_encoder.c -o bench_qr_encoder
+//   ./bench_qr_encoder [PayloadCount] [Rounds] [CsvPath]
+//
+// Encodes the same set of JSON-like payloads one at a time through
+// GenerateComputerInfoQrCode, through one reused encoder context, and in a
+// single EncodeComputerInfoQrCodeBatch call on that context, and reports symbols per second
+// for each. It then reports the rate per version for payloads that just fill
+// each version at level L, and when CsvPath is given writes those rows there
+// with the time per encode split into encoder stages. The stage split comes
+// from the time stamp counter hooks in QrCode.c, so this only builds for
+// IA32 and X64 hosts.
+//
+
+#define COMPUTER_INFO_QR_STAGE_TIMING
+
+#include "stubs/Uefi.h"
+#include "stubs/Library/BaseMemoryLib.h"
+#include "stubs/Library/BaseLib.h"
+#include "stubs/Library/MemoryAllocationLib.h"
+
+#include "../ComputerInfoQrPkg/Application/QrCode.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static double
+NowSeconds(void)
+{
+  struct timespec Now;
+
+  clock_gettime(CLOCK_MONOTONIC, &Now);
+  return (double)Now.tv_sec + ((double)Now.tv_nsec / 1e9);
+}
+
+//
+// Payloads resemble the application's JSON: short keys, hex identifiers and
+// decimal sizes, at lengths spread over the first 25 versions.
+//
+static UINTN
+FillPayload(
+  UINT8  *Buffer,
+  UINTN   Length,
+  UINT32 *Seed
+  )
+{
+  static const char Keys[][8] = { "uuid", "mac", "serial", "cpu", "board", "memory", "size" };
+  UINTN             Position  = 0;
+
+  while (Position < Length) {
+    *Seed = (*Seed * 1103515245) + 12345;
+    int Written = snprintf(
+                    (char *)&Buffer[Position],
+                    Length - Position + 1,
+                    "\"%s\":\"%08X-%u\",",
+                    Keys[(*Seed >> 16) % ARRAY_SIZE(Keys)],
+                    *Seed,
+                    (*Seed >> 8) % 65536
+                    );
+    if (Written <= 0) {
+      break;
+    }
+
+    Position += (UINTN)Written;
+  }
+
+  return Length;
+}
+
+STATIC CONST char *mStageNames[QrStageCount] = {
+  "segment", "data_codewords", "reed_solomon", "interleave", "placement", "mask", "penalty"
+};
+
+//
+// Time stamp counter ticks per nanosecond, measured against the monotonic
+// clock over a short spin.
+//
+static double
+MeasureTicksPerNanosecond(void)
+{
+  double Start      = NowSeconds();
+  UINT64 StartTicks = AsmReadTsc();
+
+  while (NowSeconds() - Start < 0.05) {
+  }
+
+  return (double)(AsmReadTsc() - StartTicks) / ((NowSeconds() - Start) * 1e9);
+}
+
+//
+// Encodes one payload Rounds times and returns the elapsed seconds.
+//
+static double
+TimeEncodes(
+  CONST UINT8 *Payload,
+  UINTN        Length,
+  UINTN        Rounds
+  )
+{
+  COMPUTER_INFO_QR_CODE QrCode;
+  double                Start = NowSeconds();
+
+  for (UINTN Round = 0; Round < Rounds; Round++) {
+    if (GenerateComputerInfoQrCode(Payload, Length, &QrCode) != EFI_SUCCESS) {
+      return -1;
+    }
+  }
+
+  return NowSeconds() - Start;
+}
+
+//
+// Per version and payload kind: total seconds and stage ticks over every
+// sample.
+//
+typedef struct {
+  CONST char *Name;
+  double      Seconds;
+  UINT64      Ticks[QrStageCount];
+} BENCH_RESULT;
+
+static int
+TimeSample(
+  CONST UINT8  *Payload,
+  UINTN         Length,
+  UINTN         Rounds,
+  BENCH_RESULT *Result
+  )
+{
+  ZeroMem(mQrStageTicks, sizeof(mQrStageTicks));
+
+  double Elapsed = TimeEncodes(Payload, Length, Rounds);
+  if (Elapsed < 0) {
+    return 1;
+  }
+
+  Result->Seconds += Elapsed;
+  for (UINTN Stage = 0; Stage < QrStageCount; Stage++) {
+    Result->Ticks[Stage] += mQrStageTicks[Stage];
+  }
+
+  return 0;
+}
+
+//
+// For every version, times payloads of the byte length that just fills it at
+// level L: random bytes above 0x7F, which stay one byte segment at that
+// version, and the JSON-like text above, which may segment into a smaller
+// version and leaves the mask penalties further apart.
+//
+static int
+BenchmarkVersions(
+  UINTN  Rounds,
+  UINT32 *Seed,
+  FILE   *Csv OPTIONAL
+  )
+{
+  static UINT8 Random[COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH + 1];
+  static UINT8 Text[COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH + 1];
+  double       TicksPerNanosecond = MeasureTicksPerNanosecond();
+
+  if (Csv != NULL) {
+    fprintf(Csv, "version,payload,length,ns_per_encode,encodes_per_s");
+    for (UINTN Stage = 0; Stage < QrStageCount; Stage++) {
+      fprintf(Csv, ",%s_ns", mStageNames[Stage]);
+    }
+
+    fprintf(Csv, "\n");
+  }
+
+  printf("version  length  random/s    text/s\n");
+  for (UINTN Version = COMPUTER_INFO_QR_MIN_VERSION; Version <= COMPUTER_INFO_QR_MAX_VERSION; Version++) {
+    //
+    // A byte segment header is at most three codewords.
+    //
+    UINTN        Length     = GetDataCodewordCapacity(Version, ComputerInfoQrEccLow) - 3;
+    UINTN        Payloads   = 16;
+    BENCH_RESULT Results[2] = {
+      { .Name = "random" },
+      { .Name = "text"   }
+    };
+
+    for (UINTN Sample = 0; Sample < Payloads; Sample++) {
+      for (UINTN Index = 0; Index < Length; Index++) {
+        *Seed         = (*Seed * 1103515245) + 12345;
+        Random[Index] = (UINT8)(0x80 | (*Seed >> 16));
+      }
+
+      FillPayload(Text, Length, Seed);
+
+      if (TimeSample(Random, Length, Rounds, &Results[0]) != 0) {
+        fprintf(stderr, "version %zu random encode failed\n", Version);
+        return 1;
+      }
+
+      if (TimeSample(Text, Length, Rounds, &Results[1]) != 0) {
+        fprintf(stderr, "version %zu text encode failed\n", Version);
+        return 1;
+      }
+    }
+
+    double Symbols = (double)(Payloads * Rounds);
+    printf("%7zu  %6zu  %8.0f  %8.0f\n", Version, Length, Symbols / Results[0].Seconds, Symbols / Results[1].Seconds);
+
+    if (Csv == NULL) {
+      continue;
+    }
+
+    for (UINTN Kind = 0; Kind < ARRAY_SIZE(Results); Kind++) {
+      fprintf(
+        Csv,
+        "%zu,%s,%zu,%.1f,%.1f",
+        Version,
+        Results[Kind].Name,
+        Length,
+        (Results[Kind].Seconds * 1e9) / Symbols,
+        Symbols / Results[Kind].Seconds
+        );
+      for (UINTN Stage = 0; Stage < QrStageCount; Stage++) {
+        fprintf(Csv, ",%.1f", (double)Results[Kind].Ticks[Stage] / TicksPerNanosecond / Symbols);
+      }
+
+      fprintf(Csv, "\n");
+    }
+  }
+
+  return 0;
+}
+
+int
+main(
+  int   argc,
+  char  **argv
+  )
+{
+  UINTN  Count  = (argc > 1) ? strtoul(argv[1], NULL, 0) : 256;
+  UINTN  Rounds = (argc > 2) ? strtoul(argv[2], NULL, 0) : 4;
+  UINT32 Seed   = 0x5EED;
+
+  if ((Count == 0) || (Rounds == 0)) {
+    fprintf(stderr, "usage: %s [PayloadCount] [Rounds] [CsvPath]\n", argv[0]);
+    return 1;
+  }
+
+  FILE *Csv = NULL;
+  if (argc > 3) {
+    Csv = fopen(argv[3], "w");
+    if (Csv == NULL) {
+      fprintf(stderr, "cannot open %s\n", argv[3]);
+      return 1;
+    }
+  }
+
+  UINT8                    *Storage  = malloc(Count * (COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH + 1));
+  COMPUTER_INFO_QR_PAYLOAD *Payloads = malloc(Count * sizeof(*Payloads));
+  COMPUTER_INFO_QR_CODE    *QrCodes  = malloc(Count * sizeof(*QrCodes));
+  if ((Storage == NULL) || (Payloads == NULL) || (QrCodes == NULL)) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+
+  for (UINTN Index = 0; Index < Count; Index++) {
+    Seed = (Seed * 1103515245) + 12345;
+    UINT8 *Buffer = &Storage[Index * (COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH + 1)];
+    Payloads[Index].Payload       = Buffer;
+    Payloads[Index].PayloadLength = FillPayload(Buffer, 64 + ((Seed >> 12) % 1200), &Seed);
+  }
+
+  //
+  // Warm the template cache so every mode measures steady-state encoding.
+  //
+  PrecomputeComputerInfoQrTemplates();
+
+  double Start = NowSeconds();
+  for (UINTN Round = 0; Round < Rounds; Round++) {
+    for (UINTN Index = 0; Index < Count; Index++) {
+      if (GenerateComputerInfoQrCode(Payloads[Index].Payload, Payloads[Index].PayloadLength, &QrCodes[Index]) != EFI_SUCCESS) {
+        fprintf(stderr, "one-shot encode %zu failed\n", Index);
+        return 1;
+      }
+    }
+  }
+  double OneShot = NowSeconds() - Start;
+
+  COMPUTER_INFO_QR_ENCODER_CONTEXT Context;
+  if (InitializeComputerInfoQrEncoder(&Context) != EFI_SUCCESS) {
+    fprintf(stderr, "encoder context initialization failed\n");
+    return 1;
+  }
+
+  Start = NowSeconds();
+  for (UINTN Round = 0; Round < Rounds; Round++) {
+    for (UINTN Index = 0; Index < Count; Index++) {
+      if (EncodeComputerInfoQrCode(&Context, Payloads[Index].Payload, Payloads[Index].PayloadLength, ComputerInfoQrEccLow, &QrCodes[Index]) != EFI_SUCCESS) {
+        fprintf(stderr, "context encode %zu failed\n", Index);
+        return 1;
+      }
+    }
+  }
+  double Reused = NowSeconds() - Start;
+
+  Start = NowSeconds();
+  for (UINTN Round = 0; Round < Rounds; Round++) {
+    if (EncodeComputerInfoQrCodeBatch(&Context, Payloads, Count, ComputerInfoQrEccLow, QrCodes, NULL) != EFI_SUCCESS) {
+      fprintf(stderr, "batch encode failed\n");
+      return 1;
+    }
+  }
+  double Batch = NowSeconds() - Start;
+  FreeComputerInfoQrEncoder(&Context);
+
+  double Symbols = (double)(Count * Rounds);
+  printf("payloads %zu, rounds %zu\n", Count, Rounds);
+  printf("one-shot  %10.0f symbols/s\n", Symbols / OneShot);
+  printf("context   %10.0f symbols/s\n", Symbols / Reused);
+  printf("batch     %10.0f symbols/s\n", Symbols / Batch);
+
+  if (BenchmarkVersions(Rounds, &Seed, Csv) != 0) {
+    return 1;
+  }
+
+  if (Csv != NULL) {
+    fclose(Csv);
+  }
+
+  FreeComputerInfoQrCaches();
+  free(QrCodes);
+  free(Payloads);
+  free(Storage);
+  return 0;
+}
@@ -2,5 +2,101 @@
 #define TESTS_STUBS_LIBRARY_BASELIB_H_
 
 #include "../Uefi.h"
+#include <string.h>
+
+STATIC inline UINT64
+SwapBytes64(
+  IN UINT64 Value
+  )
+{
+  return __builtin_bswap64(Value);
+}
+
+STATIC inline UINT64
+ReadUnaligned64(
+  IN CONST UINT64 *Buffer
+  )
+{
+  UINT64 Value;
+  memcpy(&Value, Buffer, sizeof(Value));
+  return Value;
+}
+
+STATIC inline UINT64
+WriteUnaligned64(
+  OUT UINT64 *Buffer,
+  IN  UINT64  Value
+  )
+{
+  memcpy(Buffer, &Value, sizeof(Value));
+  return Value;
+}
+
+#if defined (MDE_CPU_X64)
+
+#include <cpuid.h>
+
+STATIC inline UINT32
+AsmCpuidEx(
+  IN  UINT32 Index,
+  IN  UINT32 SubIndex,
+  OUT UINT32 *Eax OPTIONAL,
+  OUT UINT32 *Ebx OPTIONAL,
+  OUT UINT32 *Ecx OPTIONAL,
+  OUT UINT32 *Edx OPTIONAL
+  )
+{
+  UINT32 Registers[4];
+
+  __cpuid_count(Index, SubIndex, Registers[0], Registers[1], Registers[2], Registers[3]);
+  if (Eax != NULL) {
+    *Eax = Registers[0];
+  }
+  if (Ebx != NULL) {
+    *Ebx = Registers[1];
+  }
+  if (Ecx != NULL) {
+    *Ecx = Registers[2];
+  }
+  if (Edx != NULL) {
+    *Edx = Registers[3];
+  }
+
+  return Index;
+}
+
+STATIC inline UINT32
+AsmCpuid(
+  IN  UINT32 Index,
+  OUT UINT32 *Eax OPTIONAL,
+  OUT UINT32 *Ebx OPTIONAL,
+  OUT UINT32 *Ecx OPTIONAL,
+  OUT UINT32 *Edx OPTIONAL
+  )
+{
+  return AsmCpuidEx(Index, 0, Eax, Ebx, Ecx, Edx);
+}
+
+STATIC inline UINT64
+AsmXGetBv(
+  IN UINT32 Index
+  )
+{
+  UINT32 Low;
+  UINT32 High;
+
+  __asm__ __volatile__ ("xgetbv" : "=a" (Low), "=d" (High) : "c" (Index));
+  return ((UINT64)High << 32) | Low;
+}
+
+STATIC inline UINT64
+AsmReadTsc(
+  VOID
+  )
+{
+  return __builtin_ia32_rdtsc();
+}
+
+#endif
 
 #endif  // TESTS_STUBS_LIBRARY_BASELIB_H_
@@ -4,6 +4,14 @@
 #include "../Uefi.h"
 #include <stdlib.h>
 
+STATIC inline VOID *
+AllocatePool(
+  IN UINTN AllocationSize
+  )
+{
+  return (AllocationSize == 0) ? NULL : malloc(AllocationSize);
+}
+
 STATIC inline VOID *
 AllocateZeroPool(
   IN UINTN AllocationSize
@@ -0,0 +1,26 @@
+#ifndef TESTS_STUBS_LIBRARY_SYNCHRONIZATIONLIB_H_
+#define TESTS_STUBS_LIBRARY_SYNCHRONIZATIONLIB_H_
+
+#include "../Uefi.h"
+
+STATIC inline UINT32
+InterlockedCompareExchange32(
+  IN OUT volatile UINT32 *Value,
+  IN     UINT32           CompareValue,
+  IN     UINT32           ExchangeValue
+  )
+{
+  return __sync_val_compare_and_swap(Value, CompareValue, ExchangeValue);
+}
+
+STATIC inline VOID *
+InterlockedCompareExchangePointer(
+  IN OUT VOID *volatile *Value,
+  IN     VOID           *CompareValue,
+  IN     VOID           *ExchangeValue
+  )
+{
+  return __sync_val_compare_and_swap(Value, CompareValue, ExchangeValue);
+}
+
+#endif  // TESTS_STUBS_LIBRARY_SYNCHRONIZATIONLIB_H_
@@ -4,11 +4,16 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#if defined (__x86_64__)
+#define MDE_CPU_X64
+#endif
+
 #define IN
 #define OUT
 #define OPTIONAL
 #define CONST const
 #define STATIC static
+#define EFIAPI
 
 typedef void     VOID;
 typedef uint8_t  BOOLEAN;
@@ -33,10 +38,25 @@ typedef UINT64 EFI_STATUS;
 #define EFI_BAD_BUFFER_SIZE   3ULL
 #define EFI_BUFFER_TOO_SMALL  4ULL
 #define EFI_OUT_OF_RESOURCES  5ULL
+#define EFI_UNSUPPORTED       6ULL
+#define EFI_NOT_READY         7ULL
 
 #define EFI_ERROR(Status) ((Status) != EFI_SUCCESS)
 
+#define BIT1  0x00000002U
+#define BIT2  0x00000004U
+#define BIT5  0x00000020U
+#define BIT27 0x08000000U
+#define BIT28 0x10000000U
+
+#define MAX_UINT16 0xFFFFU
 #define MAX_INT32  0x7FFFFFFF
+#define MAX_UINT32 0xFFFFFFFFU
+#define MAX_UINT64 0xFFFFFFFFFFFFFFFFULL
+#define MAX_UINTN  SIZE_MAX
 #define ABS(Value) (((Value) < 0) ? -(Value) : (Value))
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#define ARRAY_SIZE(Array) (sizeof (Array) / sizeof ((Array)[0]))
 
 #endif  // TESTS_STUBS_UEFI_H_
@@ -5,6 +5,7 @@
 
 #include "../ComputerInfoQrPkg/Application/QrCode.c"
 
+#include <pthread.h>
 #include <stdio.h>
 
 static UINTN
@@ -14,7 +15,7 @@ DetermineVersionForPayload(
   )
 {
   for (UINTN Version = COMPUTER_INFO_QR_MIN_VERSION; Version <= COMPUTER_INFO_QR_MAX_VERSION; Version++) {
-    UINTN Capacity = GetDataCodewordCapacity(Version);
+    UINTN Capacity = GetDataCodewordCapacity(Version, ComputerInfoQrEccLow);
     if (Capacity == 0) {
       continue;
     }
@@ -61,13 +62,19 @@ TestBuildDataCodewordsUsesSixteenBitLength(void)
     return 1;
   }
 
-  EFI_STATUS Status = BuildDataCodewords(Payload, PayloadLength, Codewords, DataCapacity, 8);
+  //
+  // Force a single byte segment; version 9 is the last one with an 8-bit
+  // byte-mode length field.
+  //
+  QR_SEGMENT Segment = { QR_MODE_BYTE, 0, (UINT16)PayloadLength };
+
+  EFI_STATUS Status = BuildDataCodewords(Payload, &Segment, 1, NULL, 9, Codewords, DataCapacity);
   if (Status != EFI_BAD_BUFFER_SIZE) {
     fprintf(stderr, "Expected 8-bit length field rejection, got %llu\n", (unsigned long long)Status);
     return 1;
   }
 
-  Status = BuildDataCodewords(Payload, PayloadLength, Codewords, DataCapacity, CharCountBits);
+  Status = BuildDataCodewords(Payload, &Segment, 1, NULL, Version, Codewords, DataCapacity);
   if (Status != EFI_SUCCESS) {
     fprintf(stderr, "Expected success for 16-bit length field, got %llu\n", (unsigned long long)Status);
     return 1;
@@ -95,6 +102,189 @@ TestBuildDataCodewordsUsesSixteenBitLength(void)
   return 0;
 }
 
+static int
+TestBitBufferAppendBytesMatchesBitwise(void)
+{
+  UINT8 Payload[37];
+  UINT8 Bulk[48];
+  UINT8 Bitwise[48];
+
+  for (UINTN Index = 0; Index < sizeof(Payload); Index++) {
+    Payload[Index] = (UINT8)((Index * 73) ^ 0xA5);
+  }
+
+  for (UINTN Offset = 0; Offset < 8; Offset++) {
+    for (UINTN Length = 0; Length <= sizeof(Payload); Length++) {
+      QR_BIT_BUFFER BulkBuffer;
+      QR_BIT_BUFFER BitwiseBuffer;
+
+      ZeroMem(Bulk, sizeof(Bulk));
+      ZeroMem(Bitwise, sizeof(Bitwise));
+      BitBufferInit(&BulkBuffer, Bulk, sizeof(Bulk));
+      BitBufferInit(&BitwiseBuffer, Bitwise, sizeof(Bitwise));
+
+      BitBufferAppendBits(&BulkBuffer, 0x5B, Offset);
+      BitBufferAppendBits(&BitwiseBuffer, 0x5B, Offset);
+
+      EFI_STATUS Status = BitBufferAppendBytes(&BulkBuffer, Payload, Length);
+      if (Status != EFI_SUCCESS) {
+        fprintf(stderr, "Bulk append of %zu bytes at bit %zu failed with %llu\n", Length, Offset, (unsigned long long)Status);
+        return 1;
+      }
+
+      for (UINTN Index = 0; Index < Length; Index++) {
+        for (UINTN Bit = 0; Bit < 8; Bit++) {
+          BitBufferAppendBits(&BitwiseBuffer, (Payload[Index] >> (7 - Bit)) & 1, 1);
+        }
+      }
+
+      BitBufferAppendBits(&BulkBuffer, 0, 8 - BulkBuffer.PendingBits);
+      BitBufferAppendBits(&BitwiseBuffer, 0, 8 - BitwiseBuffer.PendingBits);
+
+      if ((BitBufferLength(&BulkBuffer) != BitBufferLength(&BitwiseBuffer)) ||
+          (memcmp(Bulk, Bitwise, sizeof(Bulk)) != 0)) {
+        fprintf(stderr, "Bulk append of %zu bytes at bit %zu diverged from bitwise append\n", Length, Offset);
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+static int
+TestVersionTemplatesCoverDataModules(void)
+{
+  if (PrecomputeComputerInfoQrTemplates() != EFI_SUCCESS) {
+    fprintf(stderr, "Template precomputation failed\n");
+    return 1;
+  }
+
+  for (UINTN Version = COMPUTER_INFO_QR_MIN_VERSION; Version <= COMPUTER_INFO_QR_MAX_VERSION; Version++) {
+    CONST QR_VERSION_TEMPLATE *Template = GetVersionTemplate(Version);
+    UINTN                     Size = Template->Size;
+    UINTN                     DataModules = 0;
+
+    for (UINTN Y = 0; Y < Size; Y++) {
+      for (UINTN X = 0; X < Size; X++) {
+        DataModules += QrMatrixGet(Template->FunctionModules, X, Y) ? 0 : 1;
+      }
+    }
+
+    if (DataModules != GetNumRawDataModules(Version)) {
+      fprintf(stderr, "Version %zu template leaves %zu data modules, expected %zu\n", Version, DataModules, GetNumRawDataModules(Version));
+      return 1;
+    }
+
+    static QR_FUNCTION_MATRIX Visited;
+    ZeroMem(Visited, sizeof(Visited));
+    for (UINTN Index = 0; Index < GetTotalCodewords(Version) * 8; Index++) {
+      UINTN X = Template->Placement[Index].Column;
+      UINTN Y = Template->Placement[Index].Row;
+      if ((X >= Size) || (Y >= Size) || QrMatrixGet(Template->FunctionModules, X, Y) || QrMatrixGet(Visited, X, Y)) {
+        fprintf(stderr, "Version %zu placement entry %zu is not a fresh data module\n", Version, Index);
+        return 1;
+      }
+      QrMatrixSet(Visited, X, Y, TRUE);
+    }
+  }
+
+  FreeComputerInfoQrCaches();
+  return 0;
+}
+
+static int
+TestSegmenterPicksCompactModes(void)
+{
+  static CONST struct {
+    const char  *Payload;
+    UINTN       SegmentCount;
+    UINT8       Modes[3];
+    UINTN       Bits;
+  } Cases[] = {
+    { "0123456789012345",                     1, { QR_MODE_NUMERIC },                               4 + 12 + 50 + 4 },
+    { "4C4C4544-0042-3510-8052-B4C04F4B4E32", 1, { QR_MODE_ALPHANUMERIC },                          4 + 11 + 198 },
+    { "mac=A4BB6D9F3C21A4BB6D9F",             2, { QR_MODE_BYTE, QR_MODE_ALPHANUMERIC },            (4 + 16 + 32) + (4 + 11 + 110) },
+    { "x12345678901234567890y",               3, { QR_MODE_BYTE, QR_MODE_NUMERIC, QR_MODE_BYTE },   (4 + 16 + 8) + (4 + 12 + 67) + (4 + 16 + 8) },
+  };
+  QR_SEGMENT_TRACE Trace[64];
+  QR_SEGMENT       Segments[64];
+
+  for (UINTN Index = 0; Index < ARRAY_SIZE(Cases); Index++) {
+    CONST UINT8 *Payload = (CONST UINT8 *)Cases[Index].Payload;
+    UINTN       Length = strlen(Cases[Index].Payload);
+    UINTN       SegmentCount;
+    UINTN       Bits = ComputeOptimalSegments(Payload, Length, 10, Trace, Segments, &SegmentCount);
+
+    if ((Bits != Cases[Index].Bits) || (SegmentCount != Cases[Index].SegmentCount)) {
+      fprintf(stderr, "Segmenting \"%s\" gave %zu bits in %zu segments, expected %zu in %zu\n",
+        Cases[Index].Payload, Bits, SegmentCount, Cases[Index].Bits, Cases[Index].SegmentCount);
+      return 1;
+    }
+
+    for (UINTN Segment = 0; Segment < SegmentCount; Segment++) {
+      if (Segments[Segment].Mode != Cases[Index].Modes[Segment]) {
+        fprintf(stderr, "Segment %zu of \"%s\" has mode %u\n", Segment, Cases[Index].Payload, Segments[Segment].Mode);
+        return 1;
+      }
+    }
+  }
+
+  //
+  // 300 alphanumeric characters need version 10 as bytes but fit version 9.
+  //
+  UINT8 Payload[300];
+  for (UINTN Index = 0; Index < sizeof(Payload); Index++) {
+    Payload[Index] = (UINT8)"0123456789ABCDEF:-"[Index % 18];
+  }
+
+  COMPUTER_INFO_QR_CODE QrCode;
+  EFI_STATUS Status = GenerateComputerInfoQrCode(Payload, sizeof(Payload), &QrCode);
+  if ((Status != EFI_SUCCESS) || (QrCode.Width != 4 * 9 + 17)) {
+    fprintf(stderr, "Alphanumeric payload encoded as size %zu (status %llu), expected version 9\n",
+      QrCode.Width, (unsigned long long)Status);
+    return 1;
+  }
+
+  return 0;
+}
+
+static int
+TestVersionRangeEndpoints(void)
+{
+  static COMPUTER_INFO_QR_CODE QrCode;
+  static UINT8                 Payload[COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH + 1];
+  static CONST struct {
+    UINTN      Length;
+    EFI_STATUS Status;
+    UINTN      Version;
+  } Cases[] = {
+    { 17,                                      EFI_SUCCESS,         1  },
+    { 18,                                      EFI_SUCCESS,         2  },
+    { COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH,     EFI_SUCCESS,         40 },
+    { COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH + 1, EFI_BAD_BUFFER_SIZE, 0  },
+  };
+
+  for (UINTN Index = 0; Index < sizeof(Payload); Index++) {
+    Payload[Index] = (UINT8)(0x80 | Index);
+  }
+
+  for (UINTN Index = 0; Index < ARRAY_SIZE(Cases); Index++) {
+    EFI_STATUS Status = GenerateComputerInfoQrCode(Payload, Cases[Index].Length, &QrCode);
+    if (Status != Cases[Index].Status) {
+      fprintf(stderr, "Encoding %zu bytes returned %llu\n", Cases[Index].Length, (unsigned long long)Status);
+      return 1;
+    }
+
+    if ((Status == EFI_SUCCESS) && (QrCode.Width != 4 * Cases[Index].Version + 17)) {
+      fprintf(stderr, "Encoding %zu bytes gave size %zu, expected version %zu\n", Cases[Index].Length, QrCode.Width, Cases[Index].Version);
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
 static int
 TestGenerateComputerInfoQrCodeSelectsCorrectVersion(void)
 {
@@ -111,7 +301,7 @@ TestGenerateComputerInfoQrCodeSelectsCorrectVersion(void)
     return 1;
   }
 
-  UINTN DerivedVersion = (QrCode.Size - 17) / 4;
+  UINTN DerivedVersion = (QrCode.Width - 17) / 4;
   if (DerivedVersion <= 9) {
     fprintf(stderr, "Expected QR version >= 10 for payload >255 bytes, got %zu\n", DerivedVersion);
     return 1;
@@ -120,14 +310,1292 @@ TestGenerateComputerInfoQrCodeSelectsCorrectVersion(void)
   return 0;
 }
 
-int
-main(void)
+static INT32
+ReferenceRunPenalty(
+  CONST UINT8 *Line,
+  UINTN        Length
+  )
 {
-  if (TestBuildDataCodewordsUsesSixteenBitLength() != 0) {
+  INT32 Penalty = 0;
+  UINTN RunLength = 1;
+
+  for (UINTN Index = 1; Index <= Length; Index++) {
+    if ((Index < Length) && (Line[Index] == Line[Index - 1])) {
+      RunLength++;
+      continue;
+    }
+
+    if (RunLength >= 5) {
+      Penalty += (INT32)(RunLength - 2);
+    }
+    RunLength = 1;
+  }
+
+  return Penalty;
+}
+
+static INT32
+ReferenceFinderPenalty(
+  CONST UINT8 *Line,
+  UINTN        Length
+  )
+{
+  static const UINT8 Pattern[11] = { 1, 0, 1, 1, 1, 0, 1, 0, 0, 0, 0 };
+  INT32 Penalty = 0;
+
+  for (UINTN Start = 0; Start + 11 <= Length; Start++) {
+    BOOLEAN Matches = TRUE;
+    BOOLEAN Inverse = TRUE;
+    for (UINTN Offset = 0; Offset < 11; Offset++) {
+      Matches = Matches && (Line[Start + Offset] == Pattern[Offset]);
+      Inverse = Inverse && (Line[Start + Offset] != Pattern[Offset]);
+    }
+    Penalty += (Matches ? 40 : 0) + (Inverse ? 40 : 0);
+  }
+
+  return Penalty;
+}
+
+static INT32
+ReferencePenalty(
+  CONST QR_MODULE_MATRIX Modules,
+  UINTN                  Size
+  )
+{
+  UINT8 Line[COMPUTER_INFO_QR_MAX_SIZE];
+  INT32 Penalty = 0;
+  UINTN Dark = 0;
+
+  for (UINTN Y = 0; Y < Size; Y++) {
+    for (UINTN X = 0; X < Size; X++) {
+      Line[X] = QrMatrixGet(Modules, X, Y);
+      Dark += Line[X];
+    }
+    Penalty += ReferenceRunPenalty(Line, Size) + ReferenceFinderPenalty(Line, Size);
+  }
+
+  for (UINTN X = 0; X < Size; X++) {
+    for (UINTN Y = 0; Y < Size; Y++) {
+      Line[Y] = QrMatrixGet(Modules, X, Y);
+    }
+    Penalty += ReferenceRunPenalty(Line, Size) + ReferenceFinderPenalty(Line, Size);
+  }
+
+  for (UINTN Y = 0; Y + 1 < Size; Y++) {
+    for (UINTN X = 0; X + 1 < Size; X++) {
+      BOOLEAN Value = QrMatrixGet(Modules, X, Y);
+      if ((QrMatrixGet(Modules, X + 1, Y) == Value) &&
+          (QrMatrixGet(Modules, X, Y + 1) == Value) &&
+          (QrMatrixGet(Modules, X + 1, Y + 1) == Value)) {
+        Penalty += 3;
+      }
+    }
+  }
+
+  INTN Percent = (INTN)((Dark * 100 + (Size * Size) / 2) / (Size * Size));
+  Penalty += (INT32)(ABS(Percent - 50) / 5) * 10;
+  return Penalty;
+}
+
+static int
+TestEncoderContextReuseMatchesOneShot(void)
+{
+  static COMPUTER_INFO_QR_CODE     Reused;
+  static COMPUTER_INFO_QR_CODE     OneShot;
+  COMPUTER_INFO_QR_ENCODER_CONTEXT Context;
+  UINT8                            Payload[COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH];
+  CONST UINTN                      Lengths[] = { 1000, 17, 600, 255, 256, 90 };
+
+  for (UINTN Index = 0; Index < sizeof(Payload); Index++) {
+    Payload[Index] = (UINT8)((Index * 29) + 3);
+  }
+
+  if (InitializeComputerInfoQrEncoder(&Context) != EFI_SUCCESS) {
+    fprintf(stderr, "Encoder context initialization failed\n");
     return 1;
   }
 
-  if (TestGenerateComputerInfoQrCodeSelectsCorrectVersion() != 0) {
+  for (UINTN Index = 0; Index < ARRAY_SIZE(Lengths); Index++) {
+    EFI_STATUS ReusedStatus = EncodeComputerInfoQrCode(&Context, Payload, Lengths[Index], ComputerInfoQrEccLow, &Reused);
+    EFI_STATUS OneShotStatus = GenerateComputerInfoQrCode(Payload, Lengths[Index], &OneShot);
+
+    if ((ReusedStatus != EFI_SUCCESS) || (OneShotStatus != EFI_SUCCESS) ||
+        (Reused.Width != OneShot.Width) ||
+        (memcmp(Reused.Modules, OneShot.Modules, sizeof(Reused.Modules)) != 0)) {
+      fprintf(stderr, "Reused encoder context diverged for %zu bytes\n", Lengths[Index]);
+      FreeComputerInfoQrEncoder(&Context);
+      return 1;
+    }
+  }
+
+  FreeComputerInfoQrEncoder(&Context);
+  if (Context.Arena != NULL) {
+    fprintf(stderr, "Encoder context was not cleared on free\n");
+    return 1;
+  }
+
+  return 0;
+}
+
+//
+// Reads the level back out of the first copy of the format information: bits
+// 14 and 13 sit at (0, 8) and (1, 8) before the 0x5412 mask is removed.
+//
+static UINTN
+ReadFormatLevelBits(
+  CONST COMPUTER_INFO_QR_CODE *QrCode
+  )
+{
+  UINTN Format = ((UINTN)GetComputerInfoQrModule(QrCode, 0, 8) << 14) |
+                 ((UINTN)GetComputerInfoQrModule(QrCode, 1, 8) << 13);
+  return ((Format ^ 0x5412) >> 13) & 0x3;
+}
+
+static int
+TestEccLevelSelection(void)
+{
+  static COMPUTER_INFO_QR_CODE     QrCode;
+  COMPUTER_INFO_QR_ENCODER_CONTEXT Context;
+  UINT8                            Payload[32];
+  CONST UINT8                      LevelBits[] = { 0x01, 0x00, 0x03, 0x02 };
+
+  //
+  // High bytes keep every payload in one byte segment: 12 + 8 * Length bits.
+  //
+  for (UINTN Index = 0; Index < sizeof(Payload); Index++) {
+    Payload[Index] = (UINT8)(0x80 + Index);
+  }
+
+  struct {
+    UINTN                      Length;
+    COMPUTER_INFO_QR_ECC_LEVEL Requested;
+    UINTN                      ExpectedSize;
+    COMPUTER_INFO_QR_ECC_LEVEL ExpectedLevel;
+  } CONST Cases[] = {
+    { 17, ComputerInfoQrEccLow,       21, ComputerInfoQrEccLow      },
+    { 17, ComputerInfoQrEccMedium,    25, ComputerInfoQrEccMedium   },
+    { 17, ComputerInfoQrEccQuartile,  25, ComputerInfoQrEccQuartile },
+    { 17, ComputerInfoQrEccHigh,      29, ComputerInfoQrEccHigh     },
+    { 17, ComputerInfoQrEccAutoBoost, 21, ComputerInfoQrEccLow      },
+    { 14, ComputerInfoQrEccAutoBoost, 21, ComputerInfoQrEccMedium   },
+    { 11, ComputerInfoQrEccAutoBoost, 21, ComputerInfoQrEccQuartile },
+    { 7,  ComputerInfoQrEccAutoBoost, 21, ComputerInfoQrEccHigh     },
+    { 18, ComputerInfoQrEccAutoBoost, 25, ComputerInfoQrEccQuartile },
+  };
+
+  if (InitializeComputerInfoQrEncoder(&Context) != EFI_SUCCESS) {
+    fprintf(stderr, "Encoder context initialization failed\n");
+    return 1;
+  }
+
+  for (UINTN Index = 0; Index < ARRAY_SIZE(Cases); Index++) {
+    EFI_STATUS Status = EncodeComputerInfoQrCode(&Context, Payload, Cases[Index].Length, Cases[Index].Requested, &QrCode);
+    if ((Status != EFI_SUCCESS) || (QrCode.Width != Cases[Index].ExpectedSize) ||
+        (QrCode.EccLevel != Cases[Index].ExpectedLevel) ||
+        (ReadFormatLevelBits(&QrCode) != LevelBits[Cases[Index].ExpectedLevel])) {
+      fprintf(stderr, "ECC case %zu: size %zu level %d, expected size %zu level %d\n",
+              Index, QrCode.Width, (int)QrCode.EccLevel, Cases[Index].ExpectedSize, (int)Cases[Index].ExpectedLevel);
+      FreeComputerInfoQrEncoder(&Context);
+      return 1;
+    }
+  }
+
+  EFI_STATUS Status = EncodeComputerInfoQrCode(&Context, Payload, 1, (COMPUTER_INFO_QR_ECC_LEVEL)(ComputerInfoQrEccAutoBoost + 1), &QrCode);
+  FreeComputerInfoQrEncoder(&Context);
+  if (Status != EFI_INVALID_PARAMETER) {
+    fprintf(stderr, "Out of range ECC level was accepted\n");
+    return 1;
+  }
+
+  return 0;
+}
+
+static int
+TestStructuredAppendBalancesSymbols(void)
+{
+  static UINT8                     Payload[COMPUTER_INFO_QR_MAX_STRUCTURED_APPEND_PAYLOAD_LENGTH + 1];
+  static COMPUTER_INFO_QR_CODE     QrCodes[2];
+  COMPUTER_INFO_QR_ENCODER_CONTEXT Context;
+  UINTN                            ChunkEnds[COMPUTER_INFO_QR_MAX_STRUCTURED_APPEND_SYMBOLS];
+  UINTN                            Version;
+  UINTN                            Level;
+  UINTN                            SymbolCount;
+
+  for (UINTN Index = 0; Index < sizeof(Payload); Index++) {
+    Payload[Index] = (UINT8)(0x80 | (Index * 7));
+  }
+
+  //
+  // 5000 bytes need two symbols. Split evenly, each half costs 20 + 4 + 16 +
+  // 2500 * 8 bits, which version 37 (2566 codewords) holds and version 36
+  // (2434) does not.
+  //
+  EFI_STATUS Status = PlanStructuredAppend(Payload, 5000, ComputerInfoQrEccLow, &Version, &Level, ChunkEnds, &SymbolCount);
+  if ((Status != EFI_SUCCESS) || (SymbolCount != 2) || (Version != 37) || (Level != ComputerInfoQrEccLow) ||
+      (ChunkEnds[0] != 2500) || (ChunkEnds[1] != 5000)) {
+    fprintf(stderr, "Structured Append plan: %zu symbols of version %zu, first chunk %zu\n", SymbolCount, Version, ChunkEnds[0]);
+    return 1;
+  }
+
+  if (InitializeComputerInfoQrEncoder(&Context) != EFI_SUCCESS) {
+    fprintf(stderr, "Encoder context initialization failed\n");
+    return 1;
+  }
+
+  SymbolCount = 0;
+  Status = EncodeComputerInfoQrStructuredAppend(&Context, Payload, 5000, ComputerInfoQrEccLow, NULL, &SymbolCount);
+  if ((Status != EFI_BUFFER_TOO_SMALL) || (SymbolCount != 2)) {
+    fprintf(stderr, "Structured Append size query returned %zu symbols\n", SymbolCount);
+    FreeComputerInfoQrEncoder(&Context);
+    return 1;
+  }
+
+  Status = EncodeComputerInfoQrStructuredAppend(&Context, Payload, 5000, ComputerInfoQrEccLow, QrCodes, &SymbolCount);
+  if ((Status != EFI_SUCCESS) || (SymbolCount != 2) || (QrCodes[0].Width != 165) || (QrCodes[1].Width != 165)) {
+    fprintf(stderr, "Structured Append encode produced sizes %zu and %zu\n", QrCodes[0].Width, QrCodes[1].Width);
+    FreeComputerInfoQrEncoder(&Context);
+    return 1;
+  }
+
+  SymbolCount = COMPUTER_INFO_QR_MAX_STRUCTURED_APPEND_SYMBOLS;
+  Status = EncodeComputerInfoQrStructuredAppend(&Context, Payload, sizeof(Payload), ComputerInfoQrEccLow, QrCodes, &SymbolCount);
+  FreeComputerInfoQrEncoder(&Context);
+  if (Status != EFI_BAD_BUFFER_SIZE) {
+    fprintf(stderr, "Oversized Structured Append payload was accepted\n");
+    return 1;
+  }
+
+  return 0;
+}
+
+static int
+TestBatchMatchesOneShot(void)
+{
+  static UINT8                 Payload[COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH + 1];
+  static COMPUTER_INFO_QR_CODE Batch[9];
+  static COMPUTER_INFO_QR_CODE OneShot;
+  COMPUTER_INFO_QR_PAYLOAD     Payloads[9];
+  EFI_STATUS                   Statuses[9];
+  CONST UINTN                  Lengths[9] = { 300, 17, 0, 1200, 17, 2953, 300, 2954, 90 };
+
+  for (UINTN Index = 0; Index < sizeof(Payload); Index++) {
+    Payload[Index] = (UINT8)((Index * 37) + 11);
+  }
+
+  //
+  // Entries share one buffer at different offsets, and equal lengths land in
+  // the same group out of payload order.
+  //
+  for (UINTN Index = 0; Index < ARRAY_SIZE(Payloads); Index++) {
+    Payloads[Index].Payload       = &Payload[Index];
+    Payloads[Index].PayloadLength = Lengths[Index];
+  }
+
+  COMPUTER_INFO_QR_ENCODER_CONTEXT Context;
+  if (InitializeComputerInfoQrEncoder(&Context) != EFI_SUCCESS) {
+    fprintf(stderr, "Encoder context initialization failed\n");
+    return 1;
+  }
+
+  //
+  // Round 0 uses a temporary context; later rounds reuse the caller's.
+  //
+  for (UINTN Round = 0; Round < 3; Round++) {
+    ZeroMem(Batch, sizeof(Batch));
+    EFI_STATUS Status = (Round == 0) ?
+                        GenerateComputerInfoQrCodeBatch(Payloads, ARRAY_SIZE(Payloads), ComputerInfoQrEccLow, Batch, Statuses) :
+                        EncodeComputerInfoQrCodeBatch(&Context, Payloads, ARRAY_SIZE(Payloads), ComputerInfoQrEccLow, Batch, Statuses);
+    if (Status != EFI_BAD_BUFFER_SIZE) {
+      fprintf(stderr, "Batch round %zu with invalid entries returned %llu\n", Round, (unsigned long long)Status);
+      FreeComputerInfoQrEncoder(&Context);
+      return 1;
+    }
+
+    for (UINTN Index = 0; Index < ARRAY_SIZE(Payloads); Index++) {
+      EFI_STATUS Expected = GenerateComputerInfoQrCode(Payloads[Index].Payload, Lengths[Index], &OneShot);
+      if (Statuses[Index] != Expected) {
+        fprintf(stderr, "Batch round %zu entry %zu status %llu, expected %llu\n", Round, Index, (unsigned long long)Statuses[Index], (unsigned long long)Expected);
+        FreeComputerInfoQrEncoder(&Context);
+        return 1;
+      }
+
+      if ((Expected == EFI_SUCCESS) &&
+          ((Batch[Index].Width != OneShot.Width) ||
+           (memcmp(Batch[Index].Modules, OneShot.Modules, sizeof(OneShot.Modules)) != 0))) {
+        fprintf(stderr, "Batch round %zu entry %zu diverged from a one-shot encode\n", Round, Index);
+        FreeComputerInfoQrEncoder(&Context);
+        return 1;
+      }
+    }
+  }
+
+  //
+  // A count whose bookkeeping size wraps is rejected before anything is
+  // allocated or written.
+  //
+  EFI_STATUS Status = EncodeComputerInfoQrCodeBatch(&Context, Payloads, (MAX_UINTN / 16) + 1, ComputerInfoQrEccLow, Batch, NULL);
+  FreeComputerInfoQrEncoder(&Context);
+  if (Status != EFI_INVALID_PARAMETER) {
+    fprintf(stderr, "Batch with an overflowing count returned %llu\n", (unsigned long long)Status);
+    return 1;
+  }
+
+  return 0;
+}
+
+static int
+TestEvaluatePenaltyMatchesScalarReference(void)
+{
+  static QR_MODULE_MATRIX Modules;
+  UINT32 Seed = 0x12345678;
+
+  for (UINTN Version = COMPUTER_INFO_QR_MIN_VERSION; Version <= COMPUTER_INFO_QR_MAX_VERSION; Version++) {
+    UINTN Size = 4 * Version + 17;
+    for (UINTN Round = 0; Round < 4; Round++) {
+      ZeroMem(Modules, sizeof(Modules));
+      for (UINTN Y = 0; Y < Size; Y++) {
+        for (UINTN X = 0; X < Size; X++) {
+          Seed = Seed * 1103515245 + 12345;
+          //
+          // Later rounds bias towards dark modules so long runs and
+          // finder-like windows show up in the sample.
+          //
+          QrMatrixSet(Modules, X, Y, (BOOLEAN)(((Seed >> 16) % 8) < (4 + Round / 2)));
+        }
+      }
+
+      INT32 Expected = ReferencePenalty(Modules, Size);
+      INT32 Actual   = EvaluatePenaltyBounded(Modules, Size, ScoreDarkBalance(Modules, Size), MAX_INT32);
+      if (Actual != Expected) {
+        fprintf(stderr, "Penalty mismatch for version %zu round %zu: got %d expected %d\n", Version, Round, Actual, Expected);
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+//
+// Rows streamed from a context, with no COMPUTER_INFO_QR_CODE written, and
+// from a stored symbol must both match the symbol inside every quiet zone.
+//
+static int
+TestRowIterator(void)
+{
+  static COMPUTER_INFO_QR_CODE     QrCode;
+  static UINT8                     Payload[1200];
+  COMPUTER_INFO_QR_ENCODER_CONTEXT Context;
+  COMPUTER_INFO_QR_ROW_ITERATOR    Rows[2];
+  UINT64                           Row[2][COMPUTER_INFO_QR_PADDED_ROW_WORDS];
+  UINTN                            Lengths[] = { 1, 40, 300, 1200 };
+
+  if (InitializeComputerInfoQrEncoder(&Context) != EFI_SUCCESS) {
+    fprintf(stderr, "Encoder context initialization failed\n");
+    return 1;
+  }
+
+  if (InitializeComputerInfoQrRowIterator(&Context, 0, &Rows[0]) != EFI_NOT_READY) {
+    fprintf(stderr, "A fresh context should have no rows to stream\n");
+    return 1;
+  }
+
+  for (UINTN Index = 0; Index < sizeof(Payload); Index++) {
+    Payload[Index] = (UINT8)(Index * 37 + 11);
+  }
+
+  for (UINTN Case = 0; Case < ARRAY_SIZE(Lengths); Case++) {
+    if ((EncodeComputerInfoQrCode(&Context, Payload, Lengths[Case], ComputerInfoQrEccAutoBoost, &QrCode) != EFI_SUCCESS) ||
+        (EncodeComputerInfoQrCode(&Context, Payload, Lengths[Case], ComputerInfoQrEccAutoBoost, NULL) != EFI_SUCCESS)) {
+      fprintf(stderr, "Encoding %zu bytes failed\n", Lengths[Case]);
+      return 1;
+    }
+
+    for (UINTN QuietZone = 0; QuietZone <= COMPUTER_INFO_QR_MAX_QUIET_ZONE; QuietZone++) {
+      if ((InitializeComputerInfoQrRowIterator(&Context, QuietZone, &Rows[0]) != EFI_SUCCESS) ||
+          (InitializeComputerInfoQrCodeRowIterator(&QrCode, QuietZone, &Rows[1]) != EFI_SUCCESS)) {
+        fprintf(stderr, "Row iterators failed to start for quiet zone %zu\n", QuietZone);
+        return 1;
+      }
+
+      UINTN PaddedHeight = QrCode.Height + (2 * QuietZone);
+      for (UINTN Y = 0; Y < PaddedHeight; Y++) {
+        if (!GetNextComputerInfoQrRow(&Rows[0], Row[0]) || !GetNextComputerInfoQrRow(&Rows[1], Row[1])) {
+          fprintf(stderr, "Row iterator ended early at row %zu\n", Y);
+          return 1;
+        }
+
+        for (UINTN X = 0; X < COMPUTER_INFO_QR_PADDED_ROW_WORDS * 64; X++) {
+          BOOLEAN Expected = (X >= QuietZone) && (Y >= QuietZone) &&
+                             GetComputerInfoQrModule(&QrCode, X - QuietZone, Y - QuietZone);
+          for (UINTN Source = 0; Source < 2; Source++) {
+            if ((BOOLEAN)((Row[Source][X / 64] >> (X % 64)) & 0x1) != Expected) {
+              fprintf(stderr, "Streamed row %zu of %zu bytes with quiet zone %zu is wrong at column %zu\n", Y, Lengths[Case], QuietZone, X);
+              return 1;
+            }
+          }
+        }
+      }
+
+      if (GetNextComputerInfoQrRow(&Rows[0], Row[0]) || GetNextComputerInfoQrRow(&Rows[1], Row[1])) {
+        fprintf(stderr, "Row iterator ran past %zu rows\n", PaddedHeight);
+        return 1;
+      }
+    }
+  }
+
+  if ((InitializeComputerInfoQrRowIterator(&Context, COMPUTER_INFO_QR_MAX_QUIET_ZONE + 1, &Rows[0]) != EFI_INVALID_PARAMETER) ||
+      (EncodeComputerInfoQrCode(&Context, Payload, 0, ComputerInfoQrEccLow, NULL) != EFI_BAD_BUFFER_SIZE)) {
+    fprintf(stderr, "Row iterator argument checks failed\n");
+    return 1;
+  }
+
+  FreeComputerInfoQrEncoder(&Context);
+  return 0;
+}
+
+static UINT32
+ReadStreamBits(
+  CONST UINT8 *Data,
+  UINTN       *Offset,
+  UINTN        Count
+  )
+{
+  UINT32 Value = 0;
+
+  for (UINTN Bit = 0; Bit < Count; Bit++, (*Offset)++) {
+    Value = (Value << 1) | ((Data[*Offset / 8] >> (7 - (*Offset % 8))) & 0x1);
+  }
+
+  return Value;
+}
+
+//
+// Reads an rMQR symbol back: both copies of the format information, the
+// codewords through the template placement with the mask removed, the
+// Reed-Solomon syndromes of every block and finally the data bit stream.
+// Returns the decoded length, or 0 when any step fails.
+//
+static UINTN
+DecodeRmqrSymbol(
+  CONST COMPUTER_INFO_QR_CODE *QrCode,
+  UINT8                       *Payload
+  )
+{
+  UINTN Version = RMQR_TABLES_VERSION_COUNT;
+  for (UINTN Candidate = 0; Candidate < RMQR_TABLES_VERSION_COUNT; Candidate++) {
+    if ((mRmqrVersions[Candidate].Width == QrCode->Width) && (mRmqrVersions[Candidate].Height == QrCode->Height)) {
+      Version = Candidate;
+    }
+  }
+
+  if (Version == RMQR_TABLES_VERSION_COUNT) {
+    return 0;
+  }
+
+  UINTN Level = (QrCode->EccLevel == ComputerInfoQrEccHigh) ? 1 : 0;
+  for (UINTN Side = 0; Side < 2; Side++) {
+    UINT32 Format = 0;
+    for (UINTN Bit = 0; Bit < RMQR_FORMAT_BITS; Bit++) {
+      UINTN X;
+      UINTN Y;
+      GetRmqrFormatPosition(Bit, (BOOLEAN)(Side == 1), QrCode->Width, QrCode->Height, &X, &Y);
+      Format |= (UINT32)GetComputerInfoQrModule(QrCode, X, Y) << Bit;
+    }
+
+    Format ^= (Side == 0) ? RMQR_FINDER_FORMAT_MASK : RMQR_SUBFINDER_FORMAT_MASK;
+    if ((ComputeBchCode18(Format >> 12) != Format) || ((Format >> 12) != ((Level << 5) | Version))) {
+      return 0;
+    }
+  }
+
+  CONST QR_RMQR_TEMPLATE *Template = GetRmqrTemplate(Version);
+  UINTN                  Total     = mRmqrVersions[Version].TotalCodewords;
+  UINT8                  Codewords[COMPUTER_INFO_QR_MAX_TOTAL_CODEWORDS];
+
+  ZeroMem(Codewords, sizeof(Codewords));
+  for (UINTN Index = 0; Index < Total * 8; Index++) {
+    UINTN X = Template->Placement[Index].Column;
+    UINTN Y = Template->Placement[Index].Row;
+    UINT8 Bit = (UINT8)(GetComputerInfoQrModule(QrCode, X, Y) ^ MaskBit(RMQR_MASK, (INTN)X, (INTN)Y));
+    Codewords[Index / 8] |= (UINT8)(Bit << (7 - (Index % 8)));
+  }
+
+  UINTN NumBlocks    = mRmqrNumErrorCorrectionBlocks[Level][Version];
+  UINTN Ecc          = mRmqrEccCodewordsPerBlock[Level][Version];
+  UINTN DataCapacity = mRmqrDataCodewordCapacity[Level][Version];
+  UINTN ShortData    = (Total / NumBlocks) - Ecc;
+  UINTN NumShort     = NumBlocks - (Total % NumBlocks);
+  UINT8 Data[COMPUTER_INFO_QR_MAX_DATA_CODEWORDS];
+  UINTN DataLength = 0;
+
+  for (UINTN Block = 0; Block < NumBlocks; Block++) {
+    UINT8 Received[256];
+    UINTN Length = 0;
+
+    for (UINTN Index = 0; Index < ShortData; Index++) {
+      Received[Length++] = Codewords[(Index * NumBlocks) + Block];
+    }
+
+    if (Block >= NumShort) {
+      Received[Length++] = Codewords[(ShortData * NumBlocks) + (Block - NumShort)];
+    }
+
+    CopyMem(&Data[DataLength], Received, Length);
+    DataLength += Length;
+
+    for (UINTN Index = 0; Index < Ecc; Index++) {
+      Received[Length++] = Codewords[DataCapacity + (Index * NumBlocks) + Block];
+    }
+
+    for (UINTN Root = 0; Root < Ecc; Root++) {
+      UINT8 Syndrome = 0;
+      for (UINTN Index = 0; Index < Length; Index++) {
+        UINT8 Scaled = (Syndrome == 0) ? 0 : mGaloisExpTable[(mGaloisLogTable[Syndrome] + Root) % 255];
+        Syndrome = (UINT8)(Scaled ^ Received[Index]);
+      }
+
+      if (Syndrome != 0) {
+        return 0;
+      }
+    }
+  }
+
+  UINTN Offset = 0;
+  UINTN Decoded = 0;
+  while (Offset + 3 <= DataCapacity * 8) {
+    UINT32 Mode = ReadStreamBits(Data, &Offset, 3);
+    if ((Mode == 0) || (Mode > 3)) {
+      break;
+    }
+
+    UINTN Count = ReadStreamBits(Data, &Offset, mRmqrVersions[Version].CharCountBits[Mode - 1]);
+    for (UINTN Index = 0; Index < Count;) {
+      if (Mode == 1) {
+        UINTN  Digits = MIN(Count - Index, 3);
+        UINT32 Value  = ReadStreamBits(Data, &Offset, (Digits * 3) + 1);
+        for (UINTN Digit = Digits; Digit > 0; Digit--, Value /= 10) {
+          Payload[Decoded + Index + Digit - 1] = (UINT8)('0' + (Value % 10));
+        }
+        Index += Digits;
+      } else if (Mode == 2) {
+        static CONST char Alphabet[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ $%*+-./:";
+        if (Count - Index >= 2) {
+          UINT32 Value = ReadStreamBits(Data, &Offset, 11);
+          Payload[Decoded + Index]     = (UINT8)Alphabet[Value / 45];
+          Payload[Decoded + Index + 1] = (UINT8)Alphabet[Value % 45];
+          Index += 2;
+        } else {
+          Payload[Decoded + Index] = (UINT8)Alphabet[ReadStreamBits(Data, &Offset, 6)];
+          Index++;
+        }
+      } else {
+        Payload[Decoded + Index] = (UINT8)ReadStreamBits(Data, &Offset, 8);
+        Index++;
+      }
+    }
+
+    Decoded += Count;
+  }
+
+  return Decoded;
+}
+
+//
+// rMQR templates must leave room for exactly the codewords plus the
+// standard's remainder bits, and encoded symbols must decode back to their
+// payload at the version the display area calls for.
+//
+static int
+TestRmqrSymbols(void)
+{
+  static CONST UINT8 RemainderBits[RMQR_TABLES_VERSION_COUNT] = {
+    0, 3, 5, 6, 1, 2, 3, 1, 4, 5, 2, 1, 0, 2, 7, 6,
+    4, 1, 6, 4, 3, 0, 1, 4, 6, 7, 2, 1, 2, 0, 3, 4
+  };
+  static CONST struct {
+    const char                 *Payload;
+    COMPUTER_INFO_QR_ECC_LEVEL Level;
+    UINTN                      AreaWidth;
+    UINTN                      AreaHeight;
+    UINTN                      Width;
+    UINTN                      Height;
+    COMPUTER_INFO_QR_ECC_LEVEL EncodedLevel;
+  } Cases[] = {
+    { "4C4C4544-0042-3510-8052-B4C04F4B4E32", ComputerInfoQrEccAutoBoost, 1920, 1080, 43,  13, ComputerInfoQrEccMedium },
+    { "4C4C4544-0042-3510-8052-B4C04F4B4E32", ComputerInfoQrEccMedium,    4000, 100,  99,  7,  ComputerInfoQrEccMedium },
+    { "A4:BB:6D:9F:3C:21",                    ComputerInfoQrEccLow,       0,    0,    43,  11, ComputerInfoQrEccMedium },
+    { "serial=PF3A9K2X 0123456789012",        ComputerInfoQrEccHigh,      1280, 800,  0,   0,  ComputerInfoQrEccHigh },
+    { "12345",                                ComputerInfoQrEccAutoBoost, 0,    0,    27,  11, ComputerInfoQrEccHigh },
+  };
+  COMPUTER_INFO_QR_ENCODER_CONTEXT Context;
+  COMPUTER_INFO_QR_CODE            QrCode;
+  COMPUTER_INFO_QR_ROW_ITERATOR    Rows;
+  UINT64                           Row[COMPUTER_INFO_QR_PADDED_ROW_WORDS];
+  UINT8                            Decoded[COMPUTER_INFO_QR_RMQR_MAX_PAYLOAD_LENGTH];
+  UINT8                            Payload[COMPUTER_INFO_QR_RMQR_MAX_PAYLOAD_LENGTH + 1];
+
+  for (UINTN Version = 0; Version < RMQR_TABLES_VERSION_COUNT; Version++) {
+    CONST QR_RMQR_TEMPLATE *Template = GetRmqrTemplate(Version);
+    UINTN                  Total = mRmqrVersions[Version].TotalCodewords;
+    UINTN                  DataModules = 0;
+
+    for (UINTN Y = 0; Y < Template->Height; Y++) {
+      for (UINTN X = 0; X < Template->Width; X++) {
+        DataModules += QrMatrixGet(Template->FunctionModules, X, Y) ? 0 : 1;
+      }
+    }
+
+    if (DataModules != (Total * 8) + RemainderBits[Version]) {
+      fprintf(stderr, "rMQR R%ux%u template leaves %zu data modules\n", mRmqrVersions[Version].Height, mRmqrVersions[Version].Width, DataModules);
+      return 1;
+    }
+
+    static QR_RMQR_MATRIX Visited;
+    ZeroMem(Visited, sizeof(Visited));
+    for (UINTN Index = 0; Index < Total * 8; Index++) {
+      UINTN X = Template->Placement[Index].Column;
+      UINTN Y = Template->Placement[Index].Row;
+      if ((X >= Template->Width) || (Y >= Template->Height) ||
+          QrMatrixGet(Template->FunctionModules, X, Y) || QrMatrixGet(Visited, X, Y)) {
+        fprintf(stderr, "rMQR version %zu placement entry %zu is not a fresh data module\n", Version, Index);
+        return 1;
+      }
+      QrMatrixSet(Visited, X, Y, TRUE);
+    }
+  }
+
+  if (InitializeComputerInfoQrEncoder(&Context) != EFI_SUCCESS) {
+    fprintf(stderr, "Encoder context initialization failed\n");
+    return 1;
+  }
+
+  for (UINTN Index = 0; Index < ARRAY_SIZE(Cases); Index++) {
+    UINTN Length = strlen(Cases[Index].Payload);
+
+    EFI_STATUS Status = EncodeComputerInfoQrRmqr(
+                          &Context,
+                          (CONST UINT8 *)Cases[Index].Payload,
+                          Length,
+                          Cases[Index].Level,
+                          Cases[Index].AreaWidth,
+                          Cases[Index].AreaHeight,
+                          2,
+                          &QrCode
+                          );
+    if ((Status != EFI_SUCCESS) || (QrCode.EccLevel != Cases[Index].EncodedLevel) ||
+        ((Cases[Index].Width != 0) && ((QrCode.Width != Cases[Index].Width) || (QrCode.Height != Cases[Index].Height)))) {
+      fprintf(stderr, "rMQR case %zu gave R%zux%zu at level %d (%llx)\n", Index, QrCode.Height, QrCode.Width, (int)QrCode.EccLevel, (unsigned long long)Status);
+      return 1;
+    }
+
+    if ((DecodeRmqrSymbol(&QrCode, Decoded) != Length) || (memcmp(Decoded, Cases[Index].Payload, Length) != 0)) {
+      fprintf(stderr, "rMQR case %zu does not decode to its payload\n", Index);
+      return 1;
+    }
+
+    if ((InitializeComputerInfoQrRowIterator(&Context, 1, &Rows) != EFI_SUCCESS) ||
+        (Rows.PaddedWidth != QrCode.Width + 2) || (Rows.PaddedHeight != QrCode.Height + 2)) {
+      fprintf(stderr, "rMQR case %zu streams the wrong shape\n", Index);
+      return 1;
+    }
+
+    for (UINTN Y = 0; GetNextComputerInfoQrRow(&Rows, Row); Y++) {
+      for (UINTN X = 0; X < Rows.PaddedWidth; X++) {
+        BOOLEAN Expected = (X >= 1) && (Y >= 1) && GetComputerInfoQrModule(&QrCode, X - 1, Y - 1);
+        if ((BOOLEAN)((Row[X / 64] >> (X % 64)) & 0x1) != Expected) {
+          fprintf(stderr, "rMQR case %zu streamed row %zu is wrong at column %zu\n", Index, Y, X);
+          return 1;
+        }
+      }
+    }
+  }
+
+  //
+  // 150 bytes only fit the largest symbol at level Medium.
+  //
+  for (UINTN Index = 0; Index < sizeof(Payload); Index++) {
+    Payload[Index] = (UINT8)(0x80 | (Index * 29));
+  }
+
+  if ((EncodeComputerInfoQrRmqr(&Context, Payload, COMPUTER_INFO_QR_RMQR_MAX_PAYLOAD_LENGTH, ComputerInfoQrEccAutoBoost, 0, 0, 2, &QrCode) != EFI_SUCCESS) ||
+      (QrCode.Width != 139) || (QrCode.Height != 17) || (QrCode.EccLevel != ComputerInfoQrEccMedium) ||
+      (DecodeRmqrSymbol(&QrCode, Decoded) != COMPUTER_INFO_QR_RMQR_MAX_PAYLOAD_LENGTH) ||
+      (memcmp(Decoded, Payload, COMPUTER_INFO_QR_RMQR_MAX_PAYLOAD_LENGTH) != 0)) {
+    fprintf(stderr, "The largest rMQR payload does not round trip\n");
+    return 1;
+  }
+
+  if ((EncodeComputerInfoQrRmqr(&Context, Payload, COMPUTER_INFO_QR_RMQR_MAX_PAYLOAD_LENGTH, ComputerInfoQrEccHigh, 0, 0, 2, NULL) != EFI_BAD_BUFFER_SIZE) ||
+      (EncodeComputerInfoQrRmqr(&Context, Payload, COMPUTER_INFO_QR_RMQR_MAX_PAYLOAD_LENGTH + 1, ComputerInfoQrEccMedium, 0, 0, 2, NULL) != EFI_BAD_BUFFER_SIZE)) {
+    fprintf(stderr, "Oversized rMQR payloads were accepted\n");
+    return 1;
+  }
+
+  FreeComputerInfoQrEncoder(&Context);
+  FreeComputerInfoQrCaches();
+  return 0;
+}
+
+//
+// Each mask plane must flip exactly the data modules MaskBit selects, and
+// every XOR routine the CPU can run must agree with the portable loop,
+// including word counts that leave a tail after the last full vector.
+//
+static int
+TestMaskPlanes(void)
+{
+  static UINT64 Source[COMPUTER_INFO_QR_MAX_SIZE * QR_ROW_WORDS];
+  static UINT64 Plane[COMPUTER_INFO_QR_MAX_SIZE * QR_ROW_WORDS];
+  static UINT64 Expected[COMPUTER_INFO_QR_MAX_SIZE * QR_ROW_WORDS];
+  static UINT64 Actual[COMPUTER_INFO_QR_MAX_SIZE * QR_ROW_WORDS + 1];
+  QR_XOR_WORDS  Routines[3];
+  UINTN         RoutineCount = 0;
+  UINT32        Seed         = 0x7A5C;
+
+  for (UINTN Version = COMPUTER_INFO_QR_MIN_VERSION; Version <= COMPUTER_INFO_QR_MAX_VERSION; Version++) {
+    CONST QR_VERSION_TEMPLATE *Template = GetVersionTemplate(Version);
+    UINTN                     Size      = 4 * Version + 17;
+
+    //
+    // Planes only hold Size rows.
+    //
+    for (UINTN Mask = 0; Mask < QR_MASK_COUNT; Mask++) {
+      for (UINTN Y = 0; Y < Size; Y++) {
+        for (UINTN X = 0; X < QR_ROW_WORDS * 64; X++) {
+          BOOLEAN Want = (X < Size) && !QrMatrixGet(Template->FunctionModules, X, Y) && MaskBit(Mask, (INTN)X, (INTN)Y);
+          if (QrMatrixGet(&Template->MaskPlanes[Mask * Size], X, Y) != Want) {
+            fprintf(stderr, "Mask %zu plane of version %zu is wrong at (%zu, %zu)\n", Mask, Version, X, Y);
+            return 1;
+          }
+        }
+      }
+    }
+  }
+
+  Routines[RoutineCount++] = GetXorWords();
+#if defined (MDE_CPU_X64) && defined (__GNUC__)
+  Routines[RoutineCount++] = XorWordsSse2;
+  if (QrCpuSupportsAvx2()) {
+    Routines[RoutineCount++] = XorWordsAvx2;
+  }
+#endif
+
+  for (UINTN Index = 0; Index < ARRAY_SIZE(Source); Index++) {
+    Seed          = Seed * 1103515245 + 12345;
+    Source[Index] = ((UINT64)Seed << 32) | (Seed * 2654435761U);
+    Seed          = Seed * 1103515245 + 12345;
+    Plane[Index]  = ((UINT64)Seed << 32) | (Seed * 2654435761U);
+  }
+
+  for (UINTN Routine = 0; Routine < RoutineCount; Routine++) {
+    for (UINTN Count = 0; Count <= 11; Count++) {
+      UINTN WordCount = (Count == 11) ? ARRAY_SIZE(Source) : Count;
+
+      XorWordsPortable(Expected, Source, Plane, WordCount);
+      Actual[WordCount] = 0x5A5A5A5A5A5A5A5AULL;
+      Routines[Routine](Actual, Source, Plane, WordCount);
+      if ((memcmp(Actual, Expected, WordCount * sizeof(UINT64)) != 0) || (Actual[WordCount] != 0x5A5A5A5A5A5A5A5AULL)) {
+        fprintf(stderr, "XOR routine %zu is wrong for %zu words\n", Routine, WordCount);
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+//
+// Pruned mask selection must agree with scoring all eight masks in full,
+// including the lowest-index tie break.
+//
+static int
+TestBoundedMaskSearchMatchesExhaustive(void)
+{
+  static QR_MODULE_MATRIX Base;
+  static QR_MODULE_MATRIX Candidates[QR_MASK_COUNT];
+  static QR_MODULE_MATRIX Reference;
+  UINT32                  Seed = 0xBADC0DE;
+
+  for (UINTN Version = COMPUTER_INFO_QR_MIN_VERSION; Version <= COMPUTER_INFO_QR_MAX_VERSION; Version++) {
+    CONST QR_VERSION_TEMPLATE *Template = GetVersionTemplate(Version);
+    UINTN                     Size      = 4 * Version + 17;
+
+    if (Template == NULL) {
+      fprintf(stderr, "No template for version %zu\n", Version);
+      return 1;
+    }
+
+    for (UINTN Round = 0; Round < 3; Round++) {
+      QrMatrixCopy(Base, Template->BaseModules, Size);
+      for (UINTN Y = 0; Y < Size; Y++) {
+        for (UINTN Word = 0; Word < QrRowWords(Size); Word++) {
+          Seed = Seed * 1103515245 + 12345;
+          UINT64 Random = ((UINT64)Seed << 32) | (Seed * 2654435761U);
+          UINTN  Columns = MIN(Size - Word * 64, 64);
+          if (Columns < 64) {
+            Random &= (1ULL << Columns) - 1;
+          }
+
+          Base[Y][Word] |= Random & ~Template->FunctionModules[Y][Word];
+        }
+      }
+
+      QR_MASK_SEARCH Search;
+      ZeroMem(&Search, sizeof(Search));
+      Search.BaseModules     = (CONST QR_MODULE_MATRIX *)&Base;
+      Search.MaskPlanes      = Template->MaskPlanes;
+      Search.Size            = Size;
+      Search.Level           = Round % QR_TABLES_LEVEL_COUNT;
+      Search.Candidates      = Candidates;
+
+      UINTN Selected = SelectBestMask(&Search);
+
+      UINTN ExpectedMask    = 0;
+      INT32 ExpectedPenalty = MAX_INT32;
+      for (UINTN Mask = 0; Mask < QR_MASK_COUNT; Mask++) {
+        QrMatrixCopy(Reference, Base, Size);
+        for (UINTN Y = 0; Y < Size; Y++) {
+          for (UINTN X = 0; X < Size; X++) {
+            if (!QrMatrixGet(Template->FunctionModules, X, Y) && MaskBit(Mask, (INTN)X, (INTN)Y)) {
+              QrMatrixSet(Reference, X, Y, !QrMatrixGet(Reference, X, Y));
+            }
+          }
+        }
+
+        DrawFormatBits(Reference, Search.Level, Mask, Size);
+        INT32 Penalty = ReferencePenalty(Reference, Size);
+        if (Penalty < ExpectedPenalty) {
+          ExpectedPenalty = Penalty;
+          ExpectedMask    = Mask;
+        }
+      }
+
+      if ((Selected != ExpectedMask) || (Search.Penalties[Selected] != ExpectedPenalty)) {
+        fprintf(stderr, "Version %zu round %zu picked mask %zu, exhaustive search picks %zu\n", Version, Round, Selected, ExpectedMask);
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+typedef struct {
+  COMPUTER_INFO_QR_MASK_WORKER  Worker;
+  VOID                         *WorkerContext;
+  UINTN                         CandidateCount;
+  UINTN                         NextCandidate;
+  UINTN                         CallCount;
+  pthread_mutex_t               Lock;
+} PTHREAD_MASK_JOB;
+
+static void *
+PthreadMaskThread(
+  void *Argument
+  )
+{
+  PTHREAD_MASK_JOB *Job = Argument;
+
+  while (1) {
+    pthread_mutex_lock(&Job->Lock);
+    UINTN Candidate = Job->NextCandidate++;
+    pthread_mutex_unlock(&Job->Lock);
+    if (Candidate >= Job->CandidateCount) {
+      return NULL;
+    }
+
+    Job->Worker(Job->WorkerContext, Candidate);
+    __atomic_add_fetch(&Job->CallCount, 1, __ATOMIC_RELAXED);
+  }
+}
+
+//
+// Host stand-in for the MP services backend: candidates are handed out to a
+// small pool of threads in whatever order they ask for work.
+//
+static EFI_STATUS
+EFIAPI
+DispatchMaskCandidatesPthread(
+  VOID                          *BackendContext,
+  COMPUTER_INFO_QR_MASK_WORKER   Worker,
+  VOID                          *WorkerContext,
+  UINTN                          CandidateCount
+  )
+{
+  PTHREAD_MASK_JOB *Job = BackendContext;
+  pthread_t         Threads[4];
+
+  Job->Worker         = Worker;
+  Job->WorkerContext  = WorkerContext;
+  Job->CandidateCount = CandidateCount;
+  Job->NextCandidate  = 0;
+
+  for (UINTN Index = 0; Index < 4; Index++) {
+    if (pthread_create(&Threads[Index], NULL, PthreadMaskThread, Job) != 0) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  for (UINTN Index = 0; Index < 4; Index++) {
+    pthread_join(Threads[Index], NULL);
+  }
+
+  return EFI_SUCCESS;
+}
+
+//
+// FNV-1a over the modules in row order, one step per module, so the value
+// does not depend on how the matrix is packed.
+//
+static UINT64
+HashQrModules(
+  CONST COMPUTER_INFO_QR_CODE *QrCode
+  )
+{
+  UINT64 Hash = 0xCBF29CE484222325ULL;
+
+  for (UINTN Y = 0; Y < QrCode->Height; Y++) {
+    for (UINTN X = 0; X < QrCode->Width; X++) {
+      Hash ^= GetComputerInfoQrModule(QrCode, X, Y);
+      Hash *= 0x100000001B3ULL;
+    }
+  }
+
+  return Hash;
+}
+
+//
+// Pins complete symbols for fixed payloads, so a change anywhere in the
+// shared Reed-Solomon, placement or masking code shows up even when every
+// fast path still agrees with its reference. The QR hashes were taken from
+// symbols that a decoder written apart from this encoder read back, and the
+// rMQR one from a symbol DecodeRmqrSymbol reads back; the HELLO WORLD 1-M
+// codewords are the well-known worked example.
+//
+static int
+TestGoldenSymbols(void)
+{
+  static CONST UINT8 HelloWorldCodewords[] = {
+    0x20, 0x5B, 0x0B, 0x78, 0xD1, 0x72, 0xDC, 0x4D, 0x43, 0x40, 0xEC, 0x11, 0xEC,
+    0x11, 0xEC, 0x11, 0xC4, 0x23, 0x27, 0x77, 0xEB, 0xD7, 0xE7, 0xE2, 0x5D, 0x17
+  };
+  static UINT8                 Large[COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH];
+  static COMPUTER_INFO_QR_CODE QrCode;
+  COMPUTER_INFO_QR_ENCODER_CONTEXT Context;
+
+  for (UINTN Index = 0; Index < sizeof(Large); Index++) {
+    Large[Index] = (UINT8)((Index * 131) + 7);
+  }
+
+  struct {
+    CONST UINT8                *Payload;
+    UINTN                       PayloadLength;
+    COMPUTER_INFO_QR_ECC_LEVEL  EccLevel;
+    UINTN                       Width;
+    UINT64                      Hash;
+  } Cases[] = {
+    { (CONST UINT8 *)"HELLO WORLD", 11,            ComputerInfoQrEccMedium,   21,  0x1C376158CE5B2C55ULL },
+    { (CONST UINT8 *)"HELLO WORLD", 11,            ComputerInfoQrEccQuartile, 21,  0x084D342A69849001ULL },
+    { (CONST UINT8 *)"01234567",    8,             ComputerInfoQrEccHigh,     21,  0x3D2E907509E725A7ULL },
+    { Large,                        sizeof(Large), ComputerInfoQrEccLow,      177, 0xA1856F3BEF4FB069ULL }
+  };
+
+  if (InitializeComputerInfoQrEncoder(&Context) != EFI_SUCCESS) {
+    fprintf(stderr, "Golden symbol context initialization failed\n");
+    return 1;
+  }
+
+  for (UINTN Index = 0; Index < ARRAY_SIZE(Cases); Index++) {
+    EFI_STATUS Status = EncodeComputerInfoQrCode(&Context, Cases[Index].Payload, Cases[Index].PayloadLength, Cases[Index].EccLevel, &QrCode);
+    if ((Status != EFI_SUCCESS) || (QrCode.Width != Cases[Index].Width)) {
+      fprintf(stderr, "Golden symbol %zu encoded to width %zu with %llu\n", Index, QrCode.Width, (unsigned long long)Status);
+      return 1;
+    }
+
+    if ((Index == 0) &&
+        (memcmp(((QR_ENCODER_ARENA *)Context.Arena)->Codewords, HelloWorldCodewords, sizeof(HelloWorldCodewords)) != 0)) {
+      fprintf(stderr, "HELLO WORLD 1-M codewords differ from the reference\n");
+      return 1;
+    }
+
+    if (HashQrModules(&QrCode) != Cases[Index].Hash) {
+      fprintf(stderr, "Golden symbol %zu hash is 0x%016llX\n", Index, (unsigned long long)HashQrModules(&QrCode));
+      return 1;
+    }
+  }
+
+  UINT8      Decoded[COMPUTER_INFO_QR_RMQR_MAX_PAYLOAD_LENGTH];
+  EFI_STATUS Status = EncodeComputerInfoQrRmqr(&Context, (CONST UINT8 *)"HELLO WORLD", 11, ComputerInfoQrEccMedium, 0, 0, 2, &QrCode);
+  if ((Status != EFI_SUCCESS) || (QrCode.Width != 27) || (QrCode.Height != 13) ||
+      (DecodeRmqrSymbol(&QrCode, Decoded) != 11) || (memcmp(Decoded, "HELLO WORLD", 11) != 0) ||
+      (HashQrModules(&QrCode) != 0x550EA7B335BAA7D1ULL)) {
+    fprintf(stderr, "Golden rMQR symbol is %zux%zu, hash 0x%016llX\n", QrCode.Width, QrCode.Height, (unsigned long long)HashQrModules(&QrCode));
+    return 1;
+  }
+
+  FreeComputerInfoQrEncoder(&Context);
+  return 0;
+}
+
+//
+// Two contexts encoding on their own threads must not share Reed-Solomon
+// state: the threads alternate error correction levels so their generators
+// keep differing, and every symbol must match a serial encode.
+//
+#define CONCURRENT_ENCODE_COUNT  24
+
+typedef struct {
+  UINTN                 FirstLevel;
+  UINTN                 Failures;
+  COMPUTER_INFO_QR_CODE Expected[CONCURRENT_ENCODE_COUNT];
+  COMPUTER_INFO_QR_CODE Actual;
+} CONCURRENT_ENCODE_JOB;
+
+static UINT8 mConcurrentPayload[CONCURRENT_ENCODE_COUNT][400];
+
+static COMPUTER_INFO_QR_ECC_LEVEL
+GetConcurrentEncodeLevel(
+  UINTN FirstLevel,
+  UINTN Index
+  )
+{
+  return (COMPUTER_INFO_QR_ECC_LEVEL)((FirstLevel + Index) % 4);
+}
+
+static void *
+ConcurrentEncodeThread(
+  void *Argument
+  )
+{
+  CONCURRENT_ENCODE_JOB            *Job = Argument;
+  COMPUTER_INFO_QR_ENCODER_CONTEXT  Context;
+
+  if (InitializeComputerInfoQrEncoder(&Context) != EFI_SUCCESS) {
+    Job->Failures++;
+    return NULL;
+  }
+
+  for (UINTN Round = 0; Round < 20; Round++) {
+    for (UINTN Index = 0; Index < CONCURRENT_ENCODE_COUNT; Index++) {
+      EFI_STATUS Status = EncodeComputerInfoQrCode(
+                            &Context,
+                            mConcurrentPayload[Index],
+                            40 + (Index * 15),
+                            GetConcurrentEncodeLevel(Job->FirstLevel, Index),
+                            &Job->Actual
+                            );
+      if ((Status != EFI_SUCCESS) ||
+          (memcmp(Job->Actual.Modules, Job->Expected[Index].Modules, sizeof(Job->Actual.Modules)) != 0)) {
+        Job->Failures++;
+      }
+    }
+  }
+
+  FreeComputerInfoQrEncoder(&Context);
+  return NULL;
+}
+
+static int
+TestConcurrentContextsMatchSerial(void)
+{
+  static CONCURRENT_ENCODE_JOB Jobs[2];
+  COMPUTER_INFO_QR_ENCODER_CONTEXT Context;
+  pthread_t                        Threads[2];
+  UINT32                           Seed = 0xFACADE;
+
+  for (UINTN Index = 0; Index < CONCURRENT_ENCODE_COUNT; Index++) {
+    for (UINTN Byte = 0; Byte < sizeof(mConcurrentPayload[Index]); Byte++) {
+      Seed = Seed * 1103515245 + 12345;
+      mConcurrentPayload[Index][Byte] = (UINT8)(Seed >> 16);
+    }
+  }
+
+  if (InitializeComputerInfoQrEncoder(&Context) != EFI_SUCCESS) {
+    fprintf(stderr, "Concurrent test context initialization failed\n");
+    return 1;
+  }
+
+  for (UINTN Thread = 0; Thread < 2; Thread++) {
+    Jobs[Thread].FirstLevel = Thread;
+    Jobs[Thread].Failures   = 0;
+    for (UINTN Index = 0; Index < CONCURRENT_ENCODE_COUNT; Index++) {
+      EFI_STATUS Status = EncodeComputerInfoQrCode(
+                            &Context,
+                            mConcurrentPayload[Index],
+                            40 + (Index * 15),
+                            GetConcurrentEncodeLevel(Thread, Index),
+                            &Jobs[Thread].Expected[Index]
+                            );
+      if (Status != EFI_SUCCESS) {
+        fprintf(stderr, "Concurrent test reference encode %zu failed\n", Index);
+        return 1;
+      }
+    }
+  }
+
+  FreeComputerInfoQrEncoder(&Context);
+
+  for (UINTN Thread = 0; Thread < 2; Thread++) {
+    if (pthread_create(&Threads[Thread], NULL, ConcurrentEncodeThread, &Jobs[Thread]) != 0) {
+      fprintf(stderr, "Concurrent test could not start a thread\n");
+      return 1;
+    }
+  }
+
+  for (UINTN Thread = 0; Thread < 2; Thread++) {
+    pthread_join(Threads[Thread], NULL);
+  }
+
+  if ((Jobs[0].Failures != 0) || (Jobs[1].Failures != 0)) {
+    fprintf(stderr, "Concurrent contexts produced %zu and %zu wrong symbols\n", Jobs[0].Failures, Jobs[1].Failures);
+    return 1;
+  }
+
+  return 0;
+}
+
+static int
+TestParallelMaskSearchMatchesSerial(void)
+{
+  static COMPUTER_INFO_QR_CODE Serial;
+  static COMPUTER_INFO_QR_CODE Parallel;
+  PTHREAD_MASK_JOB             Job;
+  UINT8                        Payload[COMPUTER_INFO_QR_MAX_PAYLOAD_LENGTH];
+  UINT32                       Seed = 0xC0FFEE;
+
+  ZeroMem(&Job, sizeof(Job));
+  pthread_mutex_init(&Job.Lock, NULL);
+  COMPUTER_INFO_QR_MASK_SEARCH_BACKEND Backend = { DispatchMaskCandidatesPthread, &Job };
+
+  for (UINTN PayloadLength = 1; PayloadLength <= 1000; PayloadLength += 111) {
+    for (UINTN Index = 0; Index < PayloadLength; Index++) {
+      Seed = Seed * 1103515245 + 12345;
+      Payload[Index] = (UINT8)(Seed >> 16);
+    }
+
+    SetComputerInfoQrMaskSearchBackend(NULL);
+    EFI_STATUS Status = GenerateComputerInfoQrCode(Payload, PayloadLength, &Serial);
+    if (Status != EFI_SUCCESS) {
+      fprintf(stderr, "Serial encode of %zu bytes failed with %llu\n", PayloadLength, (unsigned long long)Status);
+      return 1;
+    }
+
+    SetComputerInfoQrMaskSearchBackend(&Backend);
+    Job.CallCount = 0;
+    Status = GenerateComputerInfoQrCode(Payload, PayloadLength, &Parallel);
+#if defined (MDE_CPU_X64) && defined (__GNUC__)
+    //
+    // Workers of a backend other than the serial one may run on APs without
+    // the AVX state enabled.
+    //
+    BOOLEAN UsedSse2 = (BOOLEAN)(mXorWords == XorWordsSse2);
+#else
+    BOOLEAN UsedSse2 = TRUE;
+#endif
+    SetComputerInfoQrMaskSearchBackend(NULL);
+    if (Status != EFI_SUCCESS) {
+      fprintf(stderr, "Parallel encode of %zu bytes failed with %llu\n", PayloadLength, (unsigned long long)Status);
+      return 1;
+    }
+
+    if (!UsedSse2) {
+      fprintf(stderr, "Parallel backend was handed a routine other than SSE2\n");
+      return 1;
+    }
+
+    //
+    // Every candidate is dispatched twice: once to build and estimate it,
+    // once to score it.
+    //
+    if (Job.CallCount != 2 * QR_MASK_COUNT) {
+      fprintf(stderr, "Parallel backend ran %zu candidate calls, expected %d\n", Job.CallCount, 2 * QR_MASK_COUNT);
+      return 1;
+    }
+
+    if ((Serial.Width != Parallel.Width) ||
+        (memcmp(Serial.Modules, Parallel.Modules, sizeof(Serial.Modules)) != 0)) {
+      fprintf(stderr, "Parallel mask search diverged from serial output for %zu bytes\n", PayloadLength);
+      return 1;
+    }
+  }
+
+  pthread_mutex_destroy(&Job.Lock);
+  return 0;
+}
+
+int
+main(void)
+{
+  if (TestBuildDataCodewordsUsesSixteenBitLength() != 0) {
+    return 1;
+  }
+
+  if (TestBitBufferAppendBytesMatchesBitwise() != 0) {
+    return 1;
+  }
+
+  if (TestVersionTemplatesCoverDataModules() != 0) {
+    return 1;
+  }
+
+  if (TestSegmenterPicksCompactModes() != 0) {
+    return 1;
+  }
+
+  if (TestVersionRangeEndpoints() != 0) {
+    return 1;
+  }
+
+  if (TestGenerateComputerInfoQrCodeSelectsCorrectVersion() != 0) {
+    return 1;
+  }
+
+  if (TestEncoderContextReuseMatchesOneShot() != 0) {
+    return 1;
+  }
+
+  if (TestGoldenSymbols() != 0) {
+    return 1;
+  }
+
+  if (TestEccLevelSelection() != 0) {
+    return 1;
+  }
+
+  if (TestStructuredAppendBalancesSymbols() != 0) {
+    return 1;
+  }
+
+  if (TestRowIterator() != 0) {
+    return 1;
+  }
+
+  if (TestRmqrSymbols() != 0) {
+    return 1;
+  }
+
+  if (TestMaskPlanes() != 0) {
+    return 1;
+  }
+
+  if (TestBoundedMaskSearchMatchesExhaustive() != 0) {
+    return 1;
+  }
+
+  if (TestBatchMatchesOneShot() != 0) {
+    return 1;
+  }
+
+  if (TestEvaluatePenaltyMatchesScalarReference() != 0) {
+    return 1;
+  }
+
+  if (TestParallelMaskSearchMatchesSerial() != 0) {
+    return 1;
+  }
+
+  if (TestConcurrentContextsMatchSerial() != 0) {
     return 1;
   }
 